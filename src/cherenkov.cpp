@@ -0,0 +1,95 @@
+//********************************************************
+// Cone physics.  See cherenkov.h.
+//********************************************************
+
+#include <math.h>
+#include "cherenkov.h"
+
+static const double PI = 3.14159;
+static const double speedOfLight = 299792458.; //in m/s
+static const double refractiveIndex = 1.33;  //water
+
+// Electron, muon and pion are the viewer's original constants.  The others' masses are converted from MeV the way
+// energies are below, and their thresholds are where cos(theta) = 1 / (n*beta) first has an answer.  Gammas shower
+// in to rings like an electron's.
+static constexpr particleProperties particleTable[] = {
+	{ 11, 9.11e-31, .768, "Electron", "Positron" },
+	{ 13, 1.88352473e-28, 158.7, "Muon", "Antimuon" },
+	{ 211, 2.483e-28, 209.7, "Pion+", "Pion-" },
+	{ 321, 8.7996e-28, 748.8, "Kaon+", "Kaon-" },
+	{ 2212, 1.67244e-27, 1423.1, "Proton", "Antiproton" },
+	{ 22, 9.11e-31, .768, "Gamma", "Gamma" },
+};
+static const int numParticles = sizeof(particleTable) / sizeof(particleTable[0]);
+
+const particleProperties* findParticle(double type){
+	double code = fabs(type);
+	for(int k = 0; k < numParticles; k++){
+		if(code == particleTable[k].code){
+			return &particleTable[k];
+		}
+	}
+	return 0;
+}
+
+const char* particleName(double type){
+	const particleProperties* p = findParticle(type);
+	if(!p){
+		return 0;
+	}
+	return type > 0 ? p->name : p->antiName;
+}
+
+void particlePhysics(double type, double momentum, double& energy, double& coneAngle){
+	const particleProperties* p = findParticle(type);
+	if(!p){
+		p = &particleTable[0];  //assume electron
+	}
+	double momentumConverted = momentum * pow(10.0,6) * 1.6e-19 / 2.998e8;
+	double mass = p->mass;
+	double velocity = sqrt(pow(momentumConverted,2) / (pow(mass,2)+pow(momentumConverted,2)/pow(speedOfLight,2)));  //calculating velocity from momentum and mass, have to take in to account lorentz factor
+	energy = sqrt(pow(momentumConverted,2)*pow(speedOfLight,2)+pow(mass,2)*pow(speedOfLight,4)) / 1.602e-13;  //calculate total energy from velocity, convert to MeV
+
+	if(energy > p->threshold){ //checks if it's over cherenkov energy threshold
+		double beta = velocity / speedOfLight;  //in m/s
+		coneAngle = acos(1.0 / (beta * refractiveIndex)) * 180. / PI;  //angle in degrees, using equation cos(theta) = 1 / (n*beta) for cherenkov energy
+	}
+	else{
+		coneAngle = 0;
+	}
+}
+
+/* With pc the momentum in kg m/s and s = sqrt(pc^2 + (mc)^2), the energy is c*s and beta is |pc| / s, so
+cos(theta) = s / (n |pc|): one square root a particle, and nothing but multiplies and divides round it.  The masses
+and thresholds are looked up a block at a time first, so the middle loop is plain column arithmetic. */
+void cherenkovBatch(size_t n, const double* type, const double* momentum, double* energy, double* coneAngle){
+	const size_t block = 256;
+	double massC[block], threshold[block], cosine[block];
+	const double toSI = 1e6 * 1.6e-19 / 2.998e8;
+	const double toMeV = speedOfLight / 1.602e-13;
+	const double toDegrees = 180. / PI;
+	for(size_t first = 0; first < n; first += block){
+		size_t count = n - first < block ? n - first : block;
+		const double* t = type + first;
+		const double* m = momentum + first;
+		double* e = energy + first;
+		double* a = coneAngle + first;
+		for(size_t i = 0; i < count; i++){
+			const particleProperties* p = findParticle(t[i]);
+			if(!p){
+				p = &particleTable[0];
+			}
+			massC[i] = p->mass * speedOfLight;
+			threshold[i] = p->threshold;
+		}
+		for(size_t i = 0; i < count; i++){
+			double pc = m[i] * toSI;
+			double s = sqrt(pc*pc + massC[i]*massC[i]);
+			e[i] = s * toMeV;
+			cosine[i] = s / (refractiveIndex * fabs(pc));
+		}
+		for(size_t i = 0; i < count; i++){
+			a[i] = e[i] > threshold[i] ? acos(cosine[i]) * toDegrees : 0;
+		}
+	}
+}
@@ -0,0 +1,40 @@
+//********************************************************
+// Particle physics for the cone display: total energy and
+// Cherenkov cone angle from a particle's code and momentum.
+//
+// The masses and thresholds come from one table of GEANT /
+// PDG codes, known at compile time; a code that isn't in it
+// is taken for an electron, as the viewer always has.
+// cherenkovBatch() works down columns of particles, doing the
+// same sums as particlePhysics() with the pow() calls folded
+// away, so the loop vectorizes.  Nothing in here depends on
+// Syzygy or OpenGL.
+//********************************************************
+
+#ifndef CHERENKOV_H
+#define CHERENKOV_H
+
+#include <stddef.h>
+
+struct particleProperties {
+	int code;              //the particle's; the antiparticle's is -code
+	double mass;           //kg
+	double threshold;      //total energy (MeV) it has to be over to give off Cherenkov light in water
+	const char* name;      //shown in the menus
+	const char* antiName;
+};
+
+// the table entry for a code, or 0 if it has none
+const particleProperties* findParticle(double type);
+
+// the name shown in the menus, or 0 if the code isn't in the table
+const char* particleName(double type);
+
+// total energy (MeV) and Cherenkov cone angle (degrees, 0 under threshold) of one particle from its code and momentum
+// (MeV/c).  The original formulas, one particle at a time.
+void particlePhysics(double type, double momentum, double& energy, double& coneAngle);
+
+// the same for 'n' particles, from columns of codes and momenta in to columns of energies and angles
+void cherenkovBatch(size_t n, const double* type, const double* momentum, double* energy, double* coneAngle);
+
+#endif
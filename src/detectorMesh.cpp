@@ -0,0 +1,159 @@
+//********************************************************
+// Detector wireframe.  See detectorMesh.h.
+//********************************************************
+
+#include "arPrecompiled.h"
+#include <math.h>
+#include <map>
+#include "arGlut.h"
+#include "glEntryPoints.h"
+#include "detectorShape.h"
+#include "detectorMesh.h"
+
+using namespace std;
+
+double detectorMesh::length(){
+	return tankLength;
+}
+
+// Collects the lines.  A vertex is looked up by its exact float position, so lines meeting at a corner share it.
+struct meshBuilder {
+	vector<float>& vertices;
+	vector<unsigned>& indices;
+	map<pair<pair<float, float>, float>, unsigned> points;
+	meshBuilder(vector<float>& v, vector<unsigned>& i) : vertices(v), indices(i) {}
+	unsigned vertex(double x, double y, double z){
+		//the tank is built along +z from its end cap, then turned to face the other way and centred on the origin,
+		//which is where the hits are
+		float fx = (float)-x, fy = (float)y, fz = (float)(tankLength / 2 - z);
+		unsigned next = (unsigned)(vertices.size() / 3);
+		pair<map<pair<pair<float, float>, float>, unsigned>::iterator, bool> found = points.insert(make_pair(make_pair(make_pair(fx, fy), fz), next));
+		if(found.second){
+			vertices.push_back(fx);
+			vertices.push_back(fy);
+			vertices.push_back(fz);
+		}
+		return found.first->second;
+	}
+	void line(unsigned a, unsigned b){
+		indices.push_back(a);
+		indices.push_back(b);
+	}
+};
+
+// a point on one of the arcs, 'angle' up (or down, for the lower one) from the side of the tank
+struct arc {
+	double radius, offset, sweep, sign;
+	double x(double angle) const { return cos(angle) * radius - offset; }
+	double y(double angle) const { return sign * sin(angle) * radius; }
+};
+
+void detectorMesh::build(int widthSlices, int lengthSlices){
+	int across = widthSlices > 1 ? widthSlices : 2;
+	int along = lengthSlices > 1 ? lengthSlices : 2;
+	vertices.clear();
+	indices.clear();
+	meshBuilder mesh(vertices, indices);
+
+	double rTop = sqrt(radiusUpper*radiusUpper - tankHeight * tankHeight / 4) - offsetUpper;
+	double rBottom = sqrt(radiusLower*radiusLower - tankHeight * tankHeight / 4) - offsetLower;
+	arc upper = {radiusUpper, offsetUpper, asin(tankHeight / 2 / radiusUpper), 1};
+	arc lower = {radiusLower, offsetLower, asin(tankHeight / 2 / radiusLower), -1};
+	vector<double> z(along);
+	for(int j = 0; j < along; j++){
+		z[j] = tankLength * j / (along - 1);
+	}
+
+	//the walls and the arcs (both sides) each get a line along the tank from every point across, and a cross section
+	//at every step along: straight across a wall, point to point round an arc
+	for(int surface = 0; surface < 6; surface++){
+		vector<double> x(across), y(across);
+		for(int i = 0; i < across; i++){
+			double t = (double)i / (across - 1);
+			switch(surface){
+			case 0: x[i] = -rTop + 2 * rTop * t; y[i] = tankHeight / 2; break;  //top
+			case 1: x[i] = -rBottom + 2 * rBottom * t; y[i] = -tankHeight / 2; break;  //bottom
+			case 2: x[i] = upper.x(upper.sweep * t); y[i] = upper.y(upper.sweep * t); break;
+			case 3: x[i] = -upper.x(upper.sweep * t); y[i] = upper.y(upper.sweep * t); break;
+			case 4: x[i] = lower.x(lower.sweep * t); y[i] = lower.y(lower.sweep * t); break;
+			default: x[i] = -lower.x(lower.sweep * t); y[i] = lower.y(lower.sweep * t); break;
+			}
+			mesh.line(mesh.vertex(x[i], y[i], 0), mesh.vertex(x[i], y[i], tankLength));
+		}
+		bool wall = surface < 2;
+		for(int j = 0; j < along; j++){
+			if(wall){
+				mesh.line(mesh.vertex(x[0], y[0], z[j]), mesh.vertex(x[across - 1], y[across - 1], z[j]));
+				continue;
+			}
+			for(int i = 0; i + 1 < across; i++){
+				mesh.line(mesh.vertex(x[i], y[i], z[j]), mesh.vertex(x[i + 1], y[i + 1], z[j]));
+			}
+		}
+	}
+
+	//each end cap is hatched: lines from the top wall down to the bottom one, chords across each arc, and lines
+	//joining the upper arc to the lower one on either side
+	for(int end = 0; end < 2; end++){
+		double zEnd = end ? tankLength : 0;
+		for(int i = 0; i < across; i++){
+			double t = (double)i / (across - 1);
+			mesh.line(mesh.vertex(-rTop + 2 * rTop * t, tankHeight / 2, zEnd), mesh.vertex(-rBottom + 2 * rBottom * t, -tankHeight / 2, zEnd));
+			double u = upper.sweep * t, l = lower.sweep * t;
+			mesh.line(mesh.vertex(upper.x(u), upper.y(u), zEnd), mesh.vertex(-upper.x(u), upper.y(u), zEnd));
+			mesh.line(mesh.vertex(lower.x(l), lower.y(l), zEnd), mesh.vertex(-lower.x(l), lower.y(l), zEnd));
+			mesh.line(mesh.vertex(upper.x(u), upper.y(u), zEnd), mesh.vertex(lower.x(l), lower.y(l), zEnd));
+			mesh.line(mesh.vertex(-upper.x(u), upper.y(u), zEnd), mesh.vertex(-lower.x(l), lower.y(l), zEnd));
+		}
+	}
+}
+
+meshRenderer::meshRenderer() : mesh(0), vertexBuffer(0), indexBuffer(0), inBuffers(false) {
+}
+
+void meshRenderer::init(const detectorMesh& lines){
+	release();
+	mesh = &lines;
+	if(mesh->indices.empty() || !contextHasVersion(1, 5) || !loadBufferEntryPoints()){
+		return;  //client side arrays instead
+	}
+	gl.GenBuffers(1, &vertexBuffer);
+	gl.GenBuffers(1, &indexBuffer);
+	gl.BindBuffer(HK_ARRAY_BUFFER, vertexBuffer);
+	gl.BufferData(HK_ARRAY_BUFFER, mesh->vertices.size() * sizeof(float), &mesh->vertices[0], HK_STATIC_DRAW);
+	gl.BindBuffer(HK_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	gl.BufferData(HK_ELEMENT_ARRAY_BUFFER, mesh->indices.size() * sizeof(unsigned), &mesh->indices[0], HK_STATIC_DRAW);
+	gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+	gl.BindBuffer(HK_ELEMENT_ARRAY_BUFFER, 0);
+	inBuffers = true;
+}
+
+void meshRenderer::release(){
+	if(!inBuffers){
+		return;
+	}
+	gl.DeleteBuffers(1, &vertexBuffer);
+	gl.DeleteBuffers(1, &indexBuffer);
+	vertexBuffer = indexBuffer = 0;
+	inBuffers = false;
+}
+
+void meshRenderer::draw(){
+	if(!mesh || mesh->indices.empty()){
+		return;
+	}
+	glEnableClientState(GL_VERTEX_ARRAY);
+	if(inBuffers){
+		gl.BindBuffer(HK_ARRAY_BUFFER, vertexBuffer);
+		gl.BindBuffer(HK_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glVertexPointer(3, GL_FLOAT, 0, 0);
+		glDrawElements(GL_LINES, (GLsizei)mesh->indices.size(), GL_UNSIGNED_INT, 0);
+		gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+		gl.BindBuffer(HK_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	else{
+		glVertexPointer(3, GL_FLOAT, 0, &mesh->vertices[0]);
+		glDrawElements(GL_LINES, (GLsizei)mesh->indices.size(), GL_UNSIGNED_INT, &mesh->indices[0]);
+	}
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
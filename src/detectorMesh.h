@@ -0,0 +1,49 @@
+//********************************************************
+// Wireframe of the Hyper-K cross section shell, the shape
+// in detectorShape.h.
+//
+// The tank is a long prism whose cross section is two arcs
+// (upper and lower) joined by flat top and bottom walls.
+// build() works out every line of the wireframe once, in the
+// frame the hits are drawn in, as one indexed line list with
+// shared vertices.  A meshRenderer puts that in a vertex and
+// an index buffer in one GL context, and its draw() is then a
+// single glDrawElements.
+//********************************************************
+
+#ifndef DETECTORMESH_H
+#define DETECTORMESH_H
+
+#include <vector>
+
+class detectorMesh {
+public:
+	/* lays out the wireframe: 'widthSlices' lines along the tank across each wall and arc, and 'lengthSlices'
+	cross sections along its length.  Needs no GL, and can be redone at any time (init its renderers again after). */
+	void build(int widthSlices, int lengthSlices);
+	// the tank's length in feet.  It runs along z, centred on the origin.
+	static double length();
+
+	std::vector<float> vertices;    //x y z each, in feet
+	std::vector<unsigned> indices;  //two a line
+};
+
+// A mesh's lines in one GL context.  Every context the mesh is drawn in has its own; the mesh itself is shared.
+class meshRenderer {
+public:
+	meshRenderer();
+	// uploads the mesh to buffer objects in the current context, or keeps drawing it from memory if it has none.
+	// 'mesh' is drawn from until the next init.
+	void init(const detectorMesh& mesh);
+	// frees the buffers.  Needs the context init() ran in to be current.
+	void release();
+	// draws every line in one call, in the current color and line width
+	void draw();
+private:
+	const detectorMesh* mesh;
+	unsigned vertexBuffer;
+	unsigned indexBuffer;
+	bool inBuffers;
+};
+
+#endif
@@ -0,0 +1,51 @@
+//********************************************************
+// Tank geometry.  See detectorShape.h.
+//********************************************************
+
+#include <math.h>
+#include <algorithm>
+#include "detectorShape.h"
+
+using namespace std;
+
+bool insideTank(double x, double y, double z){
+	if(fabs(z) > tankLength / 2 || fabs(y) > tankHeight / 2){
+		return false;
+	}
+	double ax = fabs(x) + (y >= 0 ? offsetUpper : offsetLower);
+	double r = y >= 0 ? radiusUpper : radiusLower;
+	return ax*ax + y*y <= r*r;
+}
+
+// how far along the ray it leaves one lens (within the ends of the tank)
+static double lensExit(bool upper, const double* from, const double* d){
+	double t = 1e30;
+	if(d[2] != 0){
+		t = ((d[2] > 0 ? tankLength : -tankLength) / 2 - from[2]) / d[2];
+	}
+	if(upper ? d[1] > 0 : d[1] < 0){
+		t = min(t, ((upper ? tankHeight : -tankHeight) / 2 - from[1]) / d[1]);
+	}
+	double r = upper ? radiusUpper : radiusLower;
+	double offset = upper ? offsetUpper : offsetLower;
+	double a = d[0]*d[0] + d[1]*d[1];
+	if(a > 0){
+		for(int side = -1; side <= 1; side += 2){
+			double x = from[0] - side * offset, y = from[1];
+			double b = x*d[0] + y*d[1];
+			double c = x*x + y*y - r*r;
+			double disc = b*b - a*c;
+			t = min(t, (-b + sqrt(disc > 0 ? disc : 0)) / a);
+		}
+	}
+	return t > 0 ? t : 0;
+}
+
+double tankExit(const double* from, const double* d){
+	bool upper = from[1] >= 0;
+	double t = lensExit(upper, from, d);
+	if((from[1] + t * d[1] >= 0) != upper){
+		t = lensExit(!upper, from, d);
+	}
+	return t;
+}
@@ -0,0 +1,34 @@
+//********************************************************
+// The Hyper-K tank's shape, for geometry that isn't drawing.
+//
+// The tank is a long prism along z, centred on the origin
+// in the frame the hits are drawn in.  Its cross section is
+// two arcs (upper and lower) joined by flat top and bottom
+// walls; each arc is centred 'offset' across the axis from
+// the side it's on, so the section is convex.  detectorMesh
+// draws this shape, hkgen puts its PMTs on it and the cone
+// rings are projected on to it.  Nothing in here depends on
+// Syzygy or OpenGL.
+//********************************************************
+
+#ifndef DETECTORSHAPE_H
+#define DETECTORSHAPE_H
+
+// Tank sizing, in feet
+static const double tankLength = 49.500 * 3.28;
+static const double tankHeight = 48 * 3.28;
+static const double radiusUpper = 32 * 3.28;
+static const double radiusLower = 30 * 3.28;
+static const double offsetUpper = 8 * 3.28;
+static const double offsetLower = 6 * 3.28;
+
+// true if the point (feet) is inside the tank or on its surface
+bool insideTank(double x, double y, double z);
+
+/* how far along the ray from 'from' (inside the tank) in direction 'd' it leaves the tank, in lengths of d.  Each
+half of the section is a lens, the inside of both its circles and under its wall, so the ray leaves the half it
+starts in where it leaves the first of those; if that's past the axis it crossed in to the other half first, and
+leaves that half's lens instead. */
+double tankExit(const double* from, const double* d);
+
+#endif
@@ -0,0 +1,305 @@
+//********************************************************
+// Binary columnar event files (.hkev). See eventBinary.h for the layout.
+//********************************************************
+
+#include <stdio.h>
+#include <string.h>
+#include "eventBinary.h"
+#include "eventParser.h"
+
+using namespace std;
+
+static hkUint64 alignTo(hkUint64 value, hkUint64 alignment){
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool seekTo(FILE* f, hkUint64 offset){
+#ifdef _MSC_VER
+	return _fseeki64(f, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool writeAt(FILE* f, hkUint64 offset, const void* data, size_t bytes){
+	if(bytes == 0){
+		return true;
+	}
+	return seekTo(f, offset) && fwrite(data, 1, bytes, f) == bytes;
+}
+
+bool isEventBinaryFile(const char* path){
+	FILE* f = fopen(path, "rb");
+	if(!f){
+		return false;
+	}
+	char magic[4];
+	bool isBinary = fread(magic, 1, 4, f) == 4 && memcmp(magic, eventFileMagic, 4) == 0;
+	fclose(f);
+	return isBinary;
+}
+
+// writes the hits of one detector as column slices starting at 'first'.  The columns are already laid out as stored.
+static bool writeHitColumns(FILE* f, const hkUint64* offsets, hkUint64 first, const hitColumnsView& hits){
+	const void* columns[NUM_HIT_COLUMNS];
+	columns[HIT_NUMBER] = hits.number;
+	columns[HIT_CX] = hits.cx;
+	columns[HIT_CY] = hits.cy;
+	columns[HIT_CZ] = hits.cz;
+	columns[HIT_DX] = hits.dx;
+	columns[HIT_DY] = hits.dy;
+	columns[HIT_DZ] = hits.dz;
+	columns[HIT_CHARGE] = hits.charge;
+	columns[HIT_TIME] = hits.time;
+	for(int c = 0; c < NUM_HIT_COLUMNS; c++){
+		if(!writeAt(f, offsets[c] + first * hitColumnBytes, columns[c], hits.count * hitColumnBytes)){
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool writeParticleColumns(FILE* f, const hkUint64* offsets, hkUint64 first, const dotVector& event){
+	size_t n = event.particleType.size();
+	vector<double> column(n);
+	for(int c = 0; c < NUM_PARTICLE_COLUMNS; c++){
+		for(size_t i = 0; i < n; i++){
+			switch(c){
+				case PARTICLE_TYPE: column[i] = event.particleType[i]; break;
+				case PARTICLE_DIRX: column[i] = event.coneDirection[i][0]; break;
+				case PARTICLE_DIRY: column[i] = event.coneDirection[i][1]; break;
+				case PARTICLE_DIRZ: column[i] = event.coneDirection[i][2]; break;
+				case PARTICLE_MOMENTUM: column[i] = event.momentum[i]; break;
+				case PARTICLE_ENERGY: column[i] = event.energy[i]; break;
+				case PARTICLE_CONE_ANGLE: column[i] = event.coneAngle[i]; break;
+			}
+		}
+		if(!writeAt(f, offsets[c] + first * sizeof(double), n == 0 ? 0 : &column[0], n * sizeof(double))){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool convertTextToEventBinary(const char* textPath, const char* binaryPath, string& error){
+	//first pass: build the event table and count everything so the column offsets are known
+	mappedFile text;
+	if(!text.open(textPath, error)){
+		return false;
+	}
+	eventFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, eventFileMagic, 4);
+	header.version = eventFileVersion;
+	header.byteOrder = eventFileByteOrder;
+	header.headerSize = sizeof(eventFileHeader);
+
+	vector<eventRecord> events;
+	dotVector current;
+	double startTime = 0;
+	eventParser firstPass(text.data(), text.data() + text.size());
+	while(firstPass.loadNextEvent(current, startTime)){
+		eventRecord r;
+		memset(&r, 0, sizeof(r));
+		r.startTime = current.startTime;
+		r.endTime = current.endTime;
+		r.length = current.length;
+		for(int k = 0; k < 3; k++){
+			r.vertexPosition[k] = current.vertexPosition[k];
+		}
+		r.firstHit = header.numHits;
+		r.firstOuterHit = header.numOuterHits;
+		r.firstParticle = header.numParticles;
+		r.numHits = (hkUint32)current.dots.size();
+		r.numOuterHits = (hkUint32)current.outerDots.size();
+		r.numParticles = (hkUint32)current.particleType.size();
+		header.numHits += r.numHits;
+		header.numOuterHits += r.numOuterHits;
+		header.numParticles += r.numParticles;
+		events.push_back(r);
+
+		startTime = current.endTime;
+		current = dotVector();
+	}
+
+	header.numEvents = events.size();
+	header.eventTableOffset = alignTo(sizeof(eventFileHeader), 8);
+	hkUint64 offset = alignTo(header.eventTableOffset + events.size() * sizeof(eventRecord), 64);
+	for(int c = 0; c < NUM_HIT_COLUMNS; c++){
+		header.hitColumnOffset[c] = offset;
+		offset = alignTo(offset + header.numHits * hitColumnBytes, 64);
+	}
+	for(int c = 0; c < NUM_HIT_COLUMNS; c++){
+		header.outerHitColumnOffset[c] = offset;
+		offset = alignTo(offset + header.numOuterHits * hitColumnBytes, 64);
+	}
+	for(int c = 0; c < NUM_PARTICLE_COLUMNS; c++){
+		header.particleColumnOffset[c] = offset;
+		offset = alignTo(offset + header.numParticles * sizeof(double), 64);
+	}
+	header.fileSize = offset;
+
+	FILE* out = fopen(binaryPath, "wb");
+	if(!out){
+		error = string("unable to create ") + binaryPath;
+		return false;
+	}
+	bool ok = writeAt(out, 0, &header, sizeof(header))
+		&& writeAt(out, header.eventTableOffset, events.empty() ? 0 : &events[0], events.size() * sizeof(eventRecord));
+
+	//second pass: parse again and drop each event's hits in to its column slices
+	startTime = 0;
+	eventParser secondPass(text.data(), text.data() + text.size());
+	for(size_t e = 0; ok && e < events.size(); e++){
+		secondPass.loadNextEvent(current, startTime);
+		ok = writeHitColumns(out, header.hitColumnOffset, events[e].firstHit, current.innerHits())
+			&& writeHitColumns(out, header.outerHitColumnOffset, events[e].firstOuterHit, current.outerHits())
+			&& writeParticleColumns(out, header.particleColumnOffset, events[e].firstParticle, current);
+		startTime = current.endTime;
+		current = dotVector();
+	}
+	//pad out the last column so the file is exactly fileSize long
+	if(ok && header.fileSize > 0){
+		char zero = 0;
+		ok = writeAt(out, header.fileSize - 1, &zero, 1);
+	}
+	if(fclose(out) != 0){
+		ok = false;
+	}
+	if(!ok && error.empty()){
+		error = string("error writing ") + binaryPath;
+	}
+	return ok;
+}
+
+mappedEventFile::mappedEventFile() : base(0), mappedSize(0), header(0), events(0) {
+}
+
+mappedEventFile::~mappedEventFile(){
+	close();
+}
+
+// true if 'count' items of 'size' bytes from 'offset' end inside 'limit' bytes, written so it can't overflow
+static bool fitsIn(hkUint64 offset, hkUint64 count, hkUint64 size, hkUint64 limit){
+	return offset <= limit && count <= (limit - offset) / size;
+}
+
+// true if the range [first, first + count) lies inside [0, total)
+static bool rangeIn(hkUint64 first, hkUint64 count, hkUint64 total){
+	return first <= total && count <= total - first;
+}
+
+bool mappedEventFile::open(const char* path, string& error){
+	close();
+	if(!file.open(path, error)){
+		return false;
+	}
+	base = file.data();
+	mappedSize = file.size();
+
+	//everything below only looks at the header and event table, the hit columns are paged in when drawn
+	header = (const eventFileHeader*)base;
+	if(mappedSize < sizeof(eventFileHeader) || memcmp(header->magic, eventFileMagic, 4) != 0){
+		error = string(path) + " is not an event file";
+	}
+	else if(header->byteOrder != eventFileByteOrder){
+		error = string(path) + " was written on a machine with a different byte order";
+	}
+	else if(header->version != eventFileVersion){
+		char me[100];
+		sprintf(me, " is version %u, expected %u", (unsigned)header->version, (unsigned)eventFileVersion);
+		error = string(path) + me + " (rerun hkconvert)";
+	}
+	else if(header->fileSize != mappedSize || header->headerSize != sizeof(eventFileHeader)
+		|| !fitsIn(header->eventTableOffset, header->numEvents, sizeof(eventRecord), mappedSize)){
+		error = string(path) + " is truncated or corrupt";
+	}
+	else{
+		for(int c = 0; c < NUM_HIT_COLUMNS; c++){
+			if(!fitsIn(header->hitColumnOffset[c], header->numHits, hitColumnBytes, mappedSize)
+				|| !fitsIn(header->outerHitColumnOffset[c], header->numOuterHits, hitColumnBytes, mappedSize)){
+				error = string(path) + " is truncated or corrupt";
+			}
+		}
+		for(int c = 0; c < NUM_PARTICLE_COLUMNS; c++){
+			if(!fitsIn(header->particleColumnOffset[c], header->numParticles, sizeof(double), mappedSize)){
+				error = string(path) + " is truncated or corrupt";
+			}
+		}
+		//every event's slices have to lie inside the columns, or makeEvent would read past them
+		const eventRecord* table = (const eventRecord*)(base + header->eventTableOffset);
+		for(hkUint64 e = 0; error.empty() && e < header->numEvents; e++){
+			const eventRecord& r = table[e];
+			if(!rangeIn(r.firstHit, r.numHits, header->numHits) || !rangeIn(r.firstOuterHit, r.numOuterHits, header->numOuterHits)
+				|| !rangeIn(r.firstParticle, r.numParticles, header->numParticles)){
+				error = string(path) + " is truncated or corrupt";
+			}
+		}
+	}
+	if(!error.empty()){
+		close();
+		return false;
+	}
+	events = (const eventRecord*)(base + header->eventTableOffset);
+	return true;
+}
+
+void mappedEventFile::close(){
+	file.close();
+	base = 0;
+	mappedSize = 0;
+	header = 0;
+	events = 0;
+}
+
+size_t mappedEventFile::numEvents() const {
+	return header ? (size_t)header->numEvents : 0;
+}
+
+const eventRecord& mappedEventFile::record(size_t i) const {
+	return events[i];
+}
+
+hitColumnsView mappedEventFile::columns(const hkUint64* offsets, hkUint64 first, hkUint32 count) const {
+	hitColumnsView view;
+	view.count = count;
+	const float* c[NUM_HIT_COLUMNS];
+	for(int k = 0; k < NUM_HIT_COLUMNS; k++){
+		c[k] = (const float*)(base + offsets[k]) + first;
+	}
+	view.number = (const hkUint32*)(base + offsets[HIT_NUMBER]) + first;
+	view.cx = c[HIT_CX];
+	view.cy = c[HIT_CY];
+	view.cz = c[HIT_CZ];
+	view.dx = c[HIT_DX];
+	view.dy = c[HIT_DY];
+	view.dz = c[HIT_DZ];
+	view.charge = c[HIT_CHARGE];
+	view.time = c[HIT_TIME];
+	return view;
+}
+
+const double* mappedEventFile::particleColumn(int column) const {
+	return (const double*)(base + header->particleColumnOffset[column]);
+}
+
+void mappedEventFile::makeEvent(size_t i, dotVector& event) const {
+	const eventRecord& r = events[i];
+	event.startTime = r.startTime;
+	event.endTime = r.endTime;
+	event.length = r.length;
+	for(int k = 0; k < 3; k++){
+		event.vertexPosition[k] = r.vertexPosition[k];
+	}
+	event.mappedDots = columns(header->hitColumnOffset, r.firstHit, r.numHits);
+	event.mappedOuterDots = columns(header->outerHitColumnOffset, r.firstOuterHit, r.numOuterHits);
+	for(hkUint32 p = 0; p < r.numParticles; p++){
+		hkUint64 k = r.firstParticle + p;
+		event.particleType.push_back(particleColumn(PARTICLE_TYPE)[k]);
+		event.coneDirection.push_back(vec3((float)particleColumn(PARTICLE_DIRX)[k], (float)particleColumn(PARTICLE_DIRY)[k], (float)particleColumn(PARTICLE_DIRZ)[k]));
+		event.momentum.push_back(particleColumn(PARTICLE_MOMENTUM)[k]);
+		event.energy.push_back(particleColumn(PARTICLE_ENERGY)[k]);
+		event.coneAngle.push_back(particleColumn(PARTICLE_CONE_ANGLE)[k]);
+		addParticleDisplayState(event);
+	}
+}
@@ -0,0 +1,111 @@
+//********************************************************
+// Binary columnar event files (.hkev).
+//
+// Layout, all little-endian and 8-byte aligned:
+//   eventFileHeader
+//   eventRecord[numEvents]            the event table
+//   columns, each 64-byte aligned     hit columns for ID and OD, then particle columns
+// Each column holds the values for every event back to back, and an
+// event's eventRecord says where its slice starts. Hit columns are
+// 4 bytes a hit, laid out exactly like hitColumns (uint32 PMT number,
+// float everything else), and particle columns are doubles. The viewer
+// maps the file and points dotVector::mappedDots straight at the slices,
+// so opening a file costs about as much as reading the header.
+//********************************************************
+
+#ifndef EVENTBINARY_H
+#define EVENTBINARY_H
+
+#include <stddef.h>
+#include <string>
+#include "eventData.h"
+#include "mappedFile.h"
+
+static const char eventFileMagic[4] = { 'H', 'K', 'E', 'V' };
+static const hkUint32 eventFileVersion = 2;
+static const hkUint32 eventFileByteOrder = 0x01020304;
+
+// hit columns, stored once for the ID hits and once for the OD hits.  Each is hitColumnBytes a hit.
+enum {
+	HIT_NUMBER = 0,
+	HIT_CX, HIT_CY, HIT_CZ,
+	HIT_DX, HIT_DY, HIT_DZ,
+	HIT_CHARGE,
+	HIT_TIME,
+	NUM_HIT_COLUMNS
+};
+static const size_t hitColumnBytes = 4;
+// particle columns
+enum {
+	PARTICLE_TYPE = 0,
+	PARTICLE_DIRX, PARTICLE_DIRY, PARTICLE_DIRZ,
+	PARTICLE_MOMENTUM,
+	PARTICLE_ENERGY,
+	PARTICLE_CONE_ANGLE,
+	NUM_PARTICLE_COLUMNS
+};
+
+struct eventFileHeader {
+	char magic[4];
+	hkUint32 version;
+	hkUint32 byteOrder;
+	hkUint32 headerSize;
+	hkUint64 numEvents;
+	hkUint64 numHits;       //total ID hits in the file
+	hkUint64 numOuterHits;  //total OD hits in the file
+	hkUint64 numParticles;
+	hkUint64 eventTableOffset;
+	hkUint64 hitColumnOffset[NUM_HIT_COLUMNS];
+	hkUint64 outerHitColumnOffset[NUM_HIT_COLUMNS];
+	hkUint64 particleColumnOffset[NUM_PARTICLE_COLUMNS];
+	hkUint64 fileSize;
+};
+
+struct eventRecord {
+	double startTime;
+	double endTime;
+	double length;
+	double vertexPosition[3];
+	hkUint64 firstHit;
+	hkUint64 firstOuterHit;
+	hkUint64 firstParticle;
+	hkUint32 numHits;
+	hkUint32 numOuterHits;
+	hkUint32 numParticles;
+	hkUint32 reserved;
+};
+
+// true if the file starts with the .hkev magic number
+bool isEventBinaryFile(const char* path);
+
+// Converts a text event file (the ID/OD/TIME/VERTEX/PARTICLE/NEXTEVENT format) to a .hkev file.
+// Reads the text twice so that memory use doesn't grow with the file. Returns false and fills
+// 'error' on failure.
+bool convertTextToEventBinary(const char* textPath, const char* binaryPath, std::string& error);
+
+// A read-only memory mapping of a .hkev file.
+class mappedEventFile {
+public:
+	mappedEventFile();
+	~mappedEventFile();
+	bool open(const char* path, std::string& error);
+	void close();
+	bool isOpen() const { return base != 0; }
+	size_t numEvents() const;
+	const eventRecord& record(size_t i) const;
+	// fills 'event' with views of the event's hits. Only the (small) particle data is copied.
+	void makeEvent(size_t i, dotVector& event) const;
+private:
+	mappedEventFile(const mappedEventFile&);
+	mappedEventFile& operator=(const mappedEventFile&);
+	hitColumnsView columns(const hkUint64* offsets, hkUint64 first, hkUint32 count) const;
+	const double* particleColumn(int column) const;
+
+	mappedFile file;
+	const char* base;
+	size_t mappedSize;
+	const eventFileHeader* header;
+	const eventRecord* events;
+};
+
+#endif
@@ -0,0 +1,128 @@
+//********************************************************
+// Streaming access to event files.  See eventCache.h.
+//********************************************************
+
+#include "eventCache.h"
+#include "eventParser.h"
+
+using namespace std;
+
+bool textEventSource::open(const char* path){
+	string error;
+	return dataFile.open(path, error) && index.open(path);
+}
+
+void textEventSource::decode(size_t i, dotVector& event){
+	const eventIndexEntry& entry = index[i];
+	if(entry.offset > dataFile.size()){
+		return;  //the file shrank under us
+	}
+	event.dots.reserve(entry.numHits);
+	event.outerDots.reserve(entry.numOuterHits);
+	eventParser parser(dataFile.data() + entry.offset, dataFile.data() + dataFile.size());
+	parser.loadNextEvent(event, i == 0 ? 0.0 : index[i-1].endTime);
+}
+
+compressedEventSource::compressedEventSource(eventSource* r, double timeStep) : raw(r) {
+	vector<double> endTimes(raw->size());
+	for(size_t i = 0; i < endTimes.size(); i++){
+		endTimes[i] = raw->endTime(i);
+	}
+	bins = binEventsByTime(endTimes, timeStep);
+}
+
+void compressedEventSource::decode(size_t i, dotVector& event){
+	const eventBin& b = bins[i];
+	if(b.passThrough){
+		raw->decode(b.firstEvent, event);
+		return;
+	}
+	event.startTime = b.startTime;
+	binMerger merger(event);
+	for(size_t k = b.firstEvent; k < b.lastEvent; k++){
+		dotVector rawEvent;
+		raw->decode(k, rawEvent);
+		merger.add(rawEvent);
+	}
+	event.endTime = b.endTime;
+	event.length = event.endTime - event.startTime;
+}
+
+eventCache::eventCache(eventSource* s, size_t budget, size_t w) : source(s), byteBudget(budget), window(w), current(0), bytes(0) {
+}
+
+bool eventCache::inWindow(size_t i) const {
+	return i + window >= current && i <= current + window;
+}
+
+eventCache::entry& eventCache::load(size_t i){
+	map<size_t, entry>::iterator it = entries.find(i);
+	if(it != entries.end()){
+		lru.splice(lru.begin(), lru, it->second.lru);
+		return it->second;
+	}
+	entry& e = entries[i];
+	source->decode(i, e.event);
+	setDefaultDisplay(e.event);
+	map<size_t, vector<bool> >::iterator o = displayOverrides.find(i);
+	if(o != displayOverrides.end()){
+		e.event.doDisplay = o->second;
+	}
+	e.bytes = e.event.byteSize();
+	bytes += e.bytes;
+	lru.push_front(i);
+	e.lru = lru.begin();
+	return e;
+}
+
+//drops least recently used events until we're back under budget.  'keep' (the event being handed out) is never dropped,
+//and events in the window only go once everything outside it has.
+void eventCache::evict(size_t keep){
+	for(int pass = 0; pass < 2 && bytes > byteBudget; pass++){
+		list<size_t>::iterator it = lru.end();
+		while(it != lru.begin() && bytes > byteBudget){
+			--it;
+			size_t i = *it;
+			if(i == keep || (pass == 0 && inWindow(i))){
+				continue;
+			}
+			map<size_t, entry>::iterator e = entries.find(i);
+			bytes -= e->second.bytes;
+			it = lru.erase(it);
+			entries.erase(e);
+		}
+	}
+}
+
+dotVector& eventCache::get(size_t i){
+	entry& e = load(i);
+	evict(i);
+	return e.event;
+}
+
+void eventCache::setCurrent(size_t index){
+	if(index == current && entries.count(index)){
+		return;  //window is already in place
+	}
+	current = index;
+	get(index);
+	//decode outwards from the current event, stopping once the budget is spent
+	for(size_t d = 1; d <= window; d++){
+		if(index + d < size()){
+			if(bytes > byteBudget) break;
+			load(index + d);
+		}
+		if(index >= d){
+			if(bytes > byteBudget) break;
+			load(index - d);
+		}
+	}
+	load(index);  //most recently used again, so it's the last thing evicted
+	evict(index);
+}
+
+void eventCache::setDisplay(size_t event, size_t particle, bool on){
+	dotVector& e = get(event);
+	e.doDisplay[particle] = on;
+	displayOverrides[event] = e.doDisplay;
+}
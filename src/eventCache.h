@@ -0,0 +1,103 @@
+//********************************************************
+// Streaming access to event files.
+//
+// An eventSource can decode any single event on demand.  The
+// eventCache sits on top of one and keeps only a window of
+// decoded events around the current one, evicting the least
+// recently used events to stay inside a byte budget.  This
+// keeps memory flat however large the input file is.
+//********************************************************
+
+#ifndef EVENTCACHE_H
+#define EVENTCACHE_H
+
+#include <list>
+#include <map>
+#include <vector>
+#include "eventData.h"
+#include "eventBinary.h"
+#include "eventIndex.h"
+#include "mappedFile.h"
+
+class eventSource {
+public:
+	virtual ~eventSource() {}
+	virtual size_t size() const = 0;
+	//end time of event i, known without decoding it.  Start times chain off these.
+	virtual double endTime(size_t i) const = 0;
+	virtual void decode(size_t i, dotVector& event) = 0;
+};
+
+// Text event files.  Opening maps the file and reads (or builds) the sidecar index of
+// event offsets; decoding parses just that event, straight out of the mapping.
+class textEventSource : public eventSource {
+public:
+	bool open(const char* path);
+	size_t size() const { return index.size(); }
+	double endTime(size_t i) const { return index[i].endTime; }
+	void decode(size_t i, dotVector& event);
+private:
+	mappedFile dataFile;
+	eventIndex index;
+};
+
+// .hkev files.  Decoding only builds views in to the mapping, so this costs almost nothing.
+class binaryEventSource : public eventSource {
+public:
+	bool open(const char* path, std::string& error) { return file.open(path, error); }
+	size_t size() const { return file.numEvents(); }
+	double endTime(size_t i) const { return file.record(i).endTime; }
+	void decode(size_t i, dotVector& event) { file.makeEvent(i, event); }
+private:
+	mappedEventFile file;
+};
+
+// Time compressed view of another source (see binEventsByTime).  A bin is decoded by
+// decoding and merging its raw events, so no more than one raw event is held at a time.
+class compressedEventSource : public eventSource {
+public:
+	compressedEventSource(eventSource* raw, double timeStep);
+	size_t size() const { return bins.size(); }
+	double endTime(size_t i) const { return bins[i].endTime; }
+	void decode(size_t i, dotVector& event);
+private:
+	eventSource* raw;
+	std::vector<eventBin> bins;
+};
+
+class eventCache {
+public:
+	// 'window' events either side of the current one are decoded ahead of time
+	eventCache(eventSource* source, size_t byteBudget, size_t window);
+	size_t size() const { return source->size(); }
+	double endTime(size_t i) const { return source->endTime(i); }
+	// returns event i, decoding it if it isn't cached.  The reference is good until the next get() or setCurrent().
+	dotVector& get(size_t i);
+	// true if event i is decoded and held, so get(i) won't have to decode it
+	bool has(size_t i) const { return entries.count(i) != 0; }
+	// moves the window to 'index', decoding what's missing and evicting what's over budget
+	void setCurrent(size_t index);
+	// display toggles are kept outside the cached events, so they survive eviction
+	void setDisplay(size_t event, size_t particle, bool on);
+	size_t bytesUsed() const { return bytes; }
+private:
+	struct entry {
+		dotVector event;
+		size_t bytes;
+		std::list<size_t>::iterator lru;
+	};
+	entry& load(size_t i);
+	void evict(size_t keep);
+	bool inWindow(size_t i) const;
+
+	eventSource* source;
+	size_t byteBudget;
+	size_t window;
+	size_t current;
+	size_t bytes;
+	std::map<size_t, entry> entries;
+	std::list<size_t> lru;  //most recently used at the front
+	std::map<size_t, std::vector<bool> > displayOverrides;
+};
+
+#endif
@@ -0,0 +1,297 @@
+//********************************************************
+// Event data shared by the viewer and the offline tools.
+//********************************************************
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "cherenkov.h"
+#include "eventData.h"
+
+using namespace std;
+
+void hitColumns::reserve(size_t n){
+	number.reserve(n);
+	cx.reserve(n);
+	cy.reserve(n);
+	cz.reserve(n);
+	dx.reserve(n);
+	dy.reserve(n);
+	dz.reserve(n);
+	charge.reserve(n);
+	time.reserve(n);
+}
+
+void hitColumns::clear(){
+	number.clear();
+	cx.clear();
+	cy.clear();
+	cz.clear();
+	dx.clear();
+	dy.clear();
+	dz.clear();
+	charge.clear();
+	time.clear();
+}
+
+void hitColumns::push_back(hkUint32 hit, float x, float y, float z, float xd, float yd, float zd, float q, float t){
+	number.push_back(hit);
+	cx.push_back(x);
+	cy.push_back(y);
+	cz.push_back(z);
+	dx.push_back(xd);
+	dy.push_back(yd);
+	dz.push_back(zd);
+	charge.push_back(q);
+	time.push_back(t);
+}
+
+hitColumnsView hitColumns::view() const {
+	hitColumnsView v;
+	v.count = size();
+	if(v.count == 0){
+		return v;
+	}
+	v.number = &number[0];
+	v.cx = &cx[0];
+	v.cy = &cy[0];
+	v.cz = &cz[0];
+	v.dx = &dx[0];
+	v.dy = &dy[0];
+	v.dz = &dz[0];
+	v.charge = &charge[0];
+	v.time = &time[0];
+	return v;
+}
+
+size_t hitColumns::byteSize() const {
+	return number.capacity() * sizeof(hkUint32)
+		+ (cx.capacity() + cy.capacity() + cz.capacity() + dx.capacity() + dy.capacity() + dz.capacity()
+			+ charge.capacity() + time.capacity()) * sizeof(float);
+}
+
+size_t dotVector::byteSize() const {
+	size_t bytes = sizeof(dotVector);
+	bytes += dots.byteSize() + outerDots.byteSize();
+	bytes += (particleType.capacity() + coneAngle.capacity() + momentum.capacity() + energy.capacity()) * sizeof(double);
+	bytes += coneDirection.capacity() * sizeof(vec3);
+	bytes += (haveRingPoints.capacity() + doDisplay.capacity()) / 8;
+	for(size_t i = 0; i < particleName.size(); i++){
+		bytes += sizeof(string) + particleName[i].capacity();
+	}
+	for(size_t i = 0; i < ringPoints.size(); i++){
+		for(size_t j = 0; j < ringPoints[i].size(); j++){
+			bytes += sizeof(ringPointHolder) + ringPoints[i][j].ringPoints.capacity() * sizeof(vec3);
+		}
+	}
+	return bytes;
+}
+
+string particleNameFor(double type){
+	const char* name = particleName(type);
+	if(name){
+		return name;
+	}
+	char me[100];
+	sprintf(me,"%i",(int)type);
+	return me;
+}
+
+void addParticleDisplayState(dotVector& event){
+	//start an empty ringPoints class to be filled later
+	vector<ringPointHolder> me;
+	ringPointHolder me2;
+	me.push_back(me2);
+	me.push_back(me2);
+	event.ringPoints.push_back(me);
+	event.haveRingPoints.push_back(false); //since we haven't generated any ring points, fill this with false
+	event.doDisplay.push_back(false); //turn off all displays, the loader turns on the first particle afterwards
+	event.particleName.push_back(particleNameFor(event.particleType.back()));
+}
+
+void setDefaultDisplay(dotVector& event){
+	if(event.doDisplay.size() > 0){
+		event.doDisplay[0] = true;
+	}
+}
+
+void addParticle(dotVector& event, double type, double dx, double dy, double dz, double momentum){
+	event.particleType.push_back(type);
+
+	//normalize conedirection and store
+	double mag = pow(dx,2) + pow(dy,2) + pow(dz,2);
+	mag = sqrt(mag);
+	event.coneDirection.push_back(vec3(dx/mag,dy/mag,dz/mag));
+
+	event.coneAngle.push_back(0);
+	event.momentum.push_back(momentum);
+	event.energy.push_back(0);
+	addParticleDisplayState(event);
+}
+
+void computeConePhysics(dotVector& event){
+	size_t n = event.particleType.size();
+	if(n){
+		cherenkovBatch(n, &event.particleType[0], &event.momentum[0], &event.energy[0], &event.coneAngle[0]);
+	}
+}
+
+vector<eventBin> binEventsByTime(const vector<double>& endTimes, double timeStep){
+	vector<eventBin> bins;
+	size_t n = endTimes.size();
+	if(n == 0){
+		return bins;
+	}
+	eventBin bin;
+	bin.passThrough = true;
+	bin.firstEvent = 0;
+	bin.lastEvent = 1;
+	bin.startTime = 0;
+	bin.endTime = endTimes[0];
+	bins.push_back(bin);
+
+	bin.passThrough = false;
+	bin.firstEvent = 1;
+	size_t step = 0;
+	for(size_t i = 1; i < n; i++){
+		if(endTimes[i-1] >= timeStep * step){  //event i starts where event i-1 ended
+			bin.lastEvent = i;
+			bin.endTime = timeStep*step;
+			bins.push_back(bin);
+			bin.firstEvent = i+1;
+			bin.startTime = timeStep*step;
+			step++;
+		}
+	}
+	bin.lastEvent = n;
+	bin.endTime = endTimes[n-1];
+	bins.push_back(bin);
+	return bins;
+}
+
+//the bits of a coordinate, with -0 folded in to 0 since they compare equal
+static inline hkUint32 coordinateBits(float v){
+	hkUint32 bits;
+	v = v == 0 ? 0.0f : v;
+	memcpy(&bits, &v, sizeof(bits));
+	return bits;
+}
+
+static inline hkUint32 positionHash(float x, float y, float z){
+	hkUint64 h = coordinateBits(x) * 0x9E3779B97F4A7C15ull;
+	h = (h ^ coordinateBits(y)) * 0x9E3779B97F4A7C15ull;
+	h = (h ^ coordinateBits(z)) * 0x9E3779B97F4A7C15ull;
+	return (hkUint32)(h >> 32);
+}
+
+//rebuilds the table twice the size from the first 'count' hits.  They go in in order, so for any repeated position
+//the earliest hit sits first along the probe sequence and is the one found.
+void hitPositionIndex::grow(const hitColumns& columns, size_t count){
+	size_t size = slots.empty() ? 1024 : slots.size() * 2;
+	slots.assign(size, 0);
+	entries = 0;
+	size_t mask = size - 1;
+	for(size_t i = 0; i < count; i++){
+		float x = columns.cx[i], y = columns.cy[i], z = columns.cz[i];
+		if(x != x || y != y || z != z){
+			continue;
+		}
+		size_t s = positionHash(x, y, z) & mask;
+		while(slots[s]){
+			s = (s + 1) & mask;
+		}
+		slots[s] = (hkUint32)(i + 1);
+		entries++;
+	}
+}
+
+size_t hitPositionIndex::findOrAdd(const hitColumns& columns, float x, float y, float z, size_t added){
+	if(x != x || y != y || z != z){
+		return added;
+	}
+	//kept under half full
+	if(2 * (entries + 1) > slots.size()){
+		grow(columns, added);
+	}
+	size_t mask = slots.size() - 1;
+	size_t s = positionHash(x, y, z) & mask;
+	while(slots[s]){
+		size_t i = slots[s] - 1;
+		if(columns.cx[i] == x && columns.cy[i] == y && columns.cz[i] == z){
+			return i;
+		}
+		s = (s + 1) & mask;
+	}
+	slots[s] = (hkUint32)(added + 1);
+	entries++;
+	return added;
+}
+
+//hits at a position already in the bin add their charge to it, the rest are appended
+static void mergeHits(hitColumns& bin, hitPositionIndex& index, const hitColumnsView& hits){
+	for(size_t k = 0; k < hits.count; k++){
+		size_t l = index.findOrAdd(bin, hits.cx[k], hits.cy[k], hits.cz[k], bin.size());
+		if(l < bin.size()){
+			bin.charge[l] += hits.charge[k];
+		}
+		else{
+			bin.push_back(hits.number[k], hits.cx[k], hits.cy[k], hits.cz[k], hits.dx[k], hits.dy[k], hits.dz[k], hits.charge[k], hits.time[k]);
+		}
+	}
+}
+
+void binMerger::add(const dotVector& event){
+	mergeHits(bin.dots, inner, event.innerHits());
+	//same deal with outer dots.
+	mergeHits(bin.outerDots, outer, event.outerHits());
+	bin.energy.push_back(event.vertexPosition[0]);
+	bin.energy.push_back(event.vertexPosition[1]);
+	bin.energy.push_back(event.vertexPosition[2]);
+}
+
+//merges one bin's raw events, or hands over its single pass through event
+static void compressBin(vector<dotVector>& events, const eventBin& b, dotVector& bin){
+	if(b.passThrough){
+		bin = std::move(events[b.firstEvent]);
+		return;
+	}
+	bin.startTime = b.startTime;
+	binMerger merger(bin);
+	for(size_t i = b.firstEvent; i < b.lastEvent; i++){
+		merger.add(events[i]);
+	}
+	bin.endTime = b.endTime;
+	bin.length = bin.endTime - bin.startTime;
+}
+
+void compressEvents(vector<dotVector>& events, double timeStep, unsigned threads){
+	vector<double> endTimes(events.size());
+	for(size_t i = 0; i < events.size(); i++){
+		endTimes[i] = events[i].endTime;
+	}
+	vector<eventBin> bins = binEventsByTime(endTimes, timeStep);
+	vector<dotVector> compressed(bins.size());
+	//bins share no events, so each worker just takes the next bin nobody has started
+	if(threads == 0){
+		threads = thread::hardware_concurrency();
+	}
+	threads = (unsigned)min<size_t>(max(threads, 1u), bins.size());
+	atomic<size_t> next(0);
+	auto work = [&](){
+		for(size_t b = next++; b < bins.size(); b = next++){
+			compressBin(events, bins[b], compressed[b]);
+		}
+	};
+	vector<thread> workers;
+	for(unsigned k = 1; k < threads; k++){
+		workers.push_back(thread(work));
+	}
+	work();
+	for(size_t k = 0; k < workers.size(); k++){
+		workers[k].join();
+	}
+	events.swap(compressed);
+}
@@ -0,0 +1,164 @@
+//********************************************************
+// Event data shared by the viewer and the offline tools.
+// Nothing in here may depend on Syzygy or OpenGL, so that
+// the converter and other command-line tools can link it.
+//********************************************************
+
+#ifndef EVENTDATA_H
+#define EVENTDATA_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+typedef __int32 hkInt32;
+typedef unsigned __int32 hkUint32;
+typedef unsigned __int64 hkUint64;
+#else
+#include <stdint.h>
+typedef int32_t hkInt32;
+typedef uint32_t hkUint32;
+typedef uint64_t hkUint64;
+#endif
+
+// forward declaration for the drawing member, which is defined in skeleton.cpp
+class arMasterSlaveFramework;
+
+// Sizing of the hit disks, in feet
+static const double innerDotRad = 0.3 * 3.28;
+static const double outerDotRad = 0.2 * 3.28;
+
+// plain xyz triple, so the event data doesn't need the Syzygy math library
+struct vec3 {
+	float v[3];
+	vec3() { v[0] = v[1] = v[2] = 0; }
+	vec3(float x, float y, float z) { v[0] = x; v[1] = y; v[2] = z; }
+	float& operator[](int i) { return v[i]; }
+	float operator[](int i) const { return v[i]; }
+};
+
+// Non-owning view of one detector's hits, stored column by column: hit i is number[i], cx[i] and so on.
+// Positions are in feet.  The columns either belong to a hitColumns or live in a memory-mapped event file.
+struct hitColumnsView {
+	size_t count;
+	const hkUint32 * number;  //PMT number
+	const float * cx;
+	const float * cy;
+	const float * cz;
+	const float * dx;
+	const float * dy;
+	const float * dz;
+	const float * charge;
+	const float * time;
+	hitColumnsView() : count(0), number(0), cx(0), cy(0), cz(0), dx(0), dy(0), dz(0), charge(0), time(0) {}
+};
+
+// The hits of one detector (one each for the inner and outer cylinder), as a structure of arrays.
+// Every column is 4 bytes a hit, 36 bytes in all, so the draw and analysis loops run over packed floats.
+class hitColumns {
+public:
+	std::vector<hkUint32> number;
+	std::vector<float> cx, cy, cz;  //position in feet
+	std::vector<float> dx, dy, dz;  //direction the PMT faces
+	std::vector<float> charge;
+	std::vector<float> time;
+	size_t size() const { return number.size(); }
+	void reserve(size_t n);
+	void clear();
+	void push_back(hkUint32 hit, float x, float y, float z, float xd, float yd, float zd, float q, float t);
+	hitColumnsView view() const;
+	size_t byteSize() const;  //heap footprint
+};
+
+typedef struct ringPointHolder{  //just a wrapped vector of points
+	std::vector<vec3> ringPoints;
+}ringPointHolder;
+
+class dotVector {  //a dotVector is an individual event.
+public:
+	double startTime;
+	double endTime;
+	double length;
+	std::vector<double> particleType;  //each particleType as a double, which is encoded as GEANT particle code (http://hepunx.rl.ac.uk/BFROOT/www/Computing/Environment/NewUser/htmlbug/node51.html)
+	std::vector<std::string> particleName;  //just for ease of access, if we know what the type is (eg, muon electron pion) we'll write it in here, else we'll just enter "???"
+	std::vector<double> coneAngle;
+	std::vector<vec3> coneDirection;
+	double vertexPosition[3];
+	std::vector<bool> haveRingPoints;
+	std::vector<bool> doDisplay;
+	std::vector<std::vector<ringPointHolder> > ringPoints;
+	std::vector<double> momentum;  //momentum (in MeV ? )
+	std::vector<double> energy; //in the case of time-compression (supernova file), each consecutive 3 entries in this will be vertex positions ... else, energy in MeV
+	hitColumns dots;  //holds the inner cylinder
+	hitColumns outerDots; //holds the outer cylinder
+	hitColumnsView mappedDots;  //inner cylinder hits living in a memory-mapped event file, used instead of 'dots'
+	hitColumnsView mappedOuterDots;  //same for the outer cylinder
+	dotVector(){};
+	//the hits to draw or analyse, wherever they're stored
+	hitColumnsView innerHits() const { return mappedDots.count ? mappedDots : dots.view(); }
+	hitColumnsView outerHits() const { return mappedOuterDots.count ? mappedOuterDots : outerDots.view(); }
+	void draw(arMasterSlaveFramework& fw);
+	size_t byteSize() const;  //rough heap footprint, used for the streaming memory budget.  Mapped hits aren't counted
+};
+
+//name shown in the menus for a GEANT particle code
+std::string particleNameFor(double type);
+
+//appends an empty cone / ring entry for a particle whose type, direction, momentum, energy and angle are already stored
+void addParticleDisplayState(dotVector& event);
+
+//turns on the cone display for the first listed final state particle, which is what every event starts with
+void setDefaultDisplay(dotVector& event);
+
+//appends a final state particle read from a PARTICLE line, normalizing its cone direction.  Its energy and cone angle
+//are left at 0 for computeConePhysics, once the event's particles are all in.
+void addParticle(dotVector& event, double type, double dx, double dy, double dz, double momentum);
+
+//works out every particle's energy and cone angle from its type and momentum, in one batch (see cherenkov.h)
+void computeConePhysics(dotVector& event);
+
+// Time compression (supernova files): events are merged in to bins of timeStep seconds.
+// A bin is a run of consecutive raw events [firstEvent, lastEvent).
+struct eventBin {
+	bool passThrough;  //the bin is just raw event firstEvent, left as it is
+	size_t firstEvent;
+	size_t lastEvent;
+	double startTime;
+	double endTime;
+};
+
+// Groups events by start time the way the supernova view always has: the first event is kept on its own,
+// then a bin is closed each time an event starts at or past the next multiple of timeStep.  The event that
+// closes a bin isn't merged in to either bin.  endTimes[i] is the endTime of raw event i.
+std::vector<eventBin> binEventsByTime(const std::vector<double>& endTimes, double timeStep);
+
+// Finds hits in a hitColumns by exact position, in constant time.  An open addressed hash table of hit indices,
+// keyed on the position's bits; it keeps no copy of the positions and looks them up in the columns.
+class hitPositionIndex {
+public:
+	hitPositionIndex() : entries(0) {}
+	// index of the hit in 'columns' at exactly x y z (as compared with ==), or 'added' if there isn't one, in which
+	// case the caller appends hit 'added' there.  A position with a NaN in it never matches anything.
+	size_t findOrAdd(const hitColumns& columns, float x, float y, float z, size_t added);
+private:
+	std::vector<hkUint32> slots;  //hit index + 1, 0 for an empty slot
+	size_t entries;
+	void grow(const hitColumns& columns, size_t count);
+};
+
+// Merges raw events in to one time compression bin.
+class binMerger {
+public:
+	explicit binMerger(dotVector& b) : bin(b) {}
+	//adds one raw event: hits at a position already in the bin add their charge to it, and the vertex is appended to energy
+	void add(const dotVector& event);
+private:
+	dotVector& bin;
+	hitPositionIndex inner, outer;
+};
+
+//replaces 'events' with the time compressed events, building the bins on 'threads' threads (0 for one per core)
+void compressEvents(std::vector<dotVector>& events, double timeStep, unsigned threads = 0);
+
+#endif
@@ -0,0 +1,204 @@
+//********************************************************
+// Sidecar index for text event files.  See eventIndex.h.
+//********************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "eventIndex.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+struct eventIndexHeader {
+	char magic[4];
+	hkUint32 version;
+	hkUint64 dataSize;
+	hkUint64 dataTime;
+	hkUint64 numEvents;
+};
+
+static bool statFile(const char* path, hkUint64& size, hkUint64& time){
+#ifdef _WIN32
+	struct _stat64 st;
+	if(_stat64(path, &st) != 0){
+		return false;
+	}
+#else
+	struct stat st;
+	if(stat(path, &st) != 0){
+		return false;
+	}
+#endif
+	size = (hkUint64)st.st_size;
+	time = (hkUint64)st.st_mtime;
+	return true;
+}
+
+string eventIndex::sidecarPath(const char* dataPath){
+	return string(dataPath) + ".hkidx";
+}
+
+bool eventIndex::open(const char* dataPath){
+	if(load(dataPath)){
+		return true;
+	}
+	if(!build(dataPath)){
+		return false;
+	}
+	save(dataPath);
+	return true;
+}
+
+bool eventIndex::load(const char* dataPath){
+	rebuilt = false;
+	entries.clear();
+	if(!statFile(dataPath, dataSize, dataTime)){
+		return false;
+	}
+	FILE* f = fopen(sidecarPath(dataPath).c_str(), "rb");
+	if(!f){
+		return false;
+	}
+	eventIndexHeader header;
+	bool ok = fread(&header, sizeof(header), 1, f) == 1
+		&& memcmp(header.magic, eventIndexMagic, 4) == 0
+		&& header.version == eventIndexVersion
+		&& header.dataSize == dataSize
+		&& header.dataTime == dataTime;
+	if(ok){
+		entries.resize((size_t)header.numEvents);
+		ok = entries.empty() || fread(&entries[0], sizeof(eventIndexEntry), entries.size(), f) == entries.size();
+	}
+	fclose(f);
+	if(!ok){
+		entries.clear();
+	}
+	return ok;
+}
+
+//state for the scan in eventIndex::build
+struct eventScan {
+	vector<eventIndexEntry>& entries;
+	eventIndexEntry current;
+	bool readTime;
+	eventScan(vector<eventIndexEntry>& e) : entries(e), readTime(false) {
+		memset(&current, 0, sizeof(current));
+	}
+	//'end' is the offset just past the token.  Only a handful of keywords matter, and they're told apart by length and first byte.
+	void token(const char* t, size_t length, hkUint64 end){
+		if(readTime){
+			char number[64];
+			size_t n = length < sizeof(number) - 1 ? length : sizeof(number) - 1;
+			memcpy(number, t, n);
+			number[n] = 0;
+			current.endTime = atof(number);
+			readTime = false;
+		}
+		else if(length == 2 && t[1] == 'D'){
+			if(t[0] == 'I'){
+				current.numHits++;
+			}
+			else if(t[0] == 'O'){
+				current.numOuterHits++;
+			}
+		}
+		else if(length == 4 && memcmp(t, "TIME", 4) == 0){
+			readTime = true;
+		}
+		else if(length == 9 && memcmp(t, "NEXTEVENT", 9) == 0){
+			entries.push_back(current);
+			memset(&current, 0, sizeof(current));
+			current.offset = end;
+		}
+	}
+};
+
+static bool isSpace(char c){
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+bool eventIndex::build(const char* dataPath){
+	rebuilt = true;
+	entries.clear();
+	if(!statFile(dataPath, dataSize, dataTime)){
+		return false;
+	}
+	FILE* f = fopen(dataPath, "rb");
+	if(!f){
+		return false;
+	}
+	eventScan scan(entries);
+	vector<char> buffer(4 << 20);
+	size_t carry = 0;  //bytes of a token cut off at the end of the last block, moved to the front of the buffer
+	hkUint64 position = 0;  //file offset of buffer[0]
+	while(true){
+		size_t got = fread(&buffer[carry], 1, buffer.size() - carry, f);
+		size_t end = carry + got;
+		bool last = got == 0;
+		size_t k = 0;
+		size_t keep = end;  //start of a token cut off by the end of the block, it's moved to the front of the buffer
+		while(k < end){
+			while(k < end && isSpace(buffer[k])) k++;
+			size_t start = k;
+			while(k < end && !isSpace(buffer[k])) k++;
+			if(start == k){
+				break;
+			}
+			if(k == end && !last){
+				keep = start;  //may carry on in the next block
+				break;
+			}
+			scan.token(&buffer[start], k - start, position + k);
+		}
+		if(last){
+			break;
+		}
+		carry = end - keep;
+		if(carry == buffer.size()){
+			carry = 0;  //a single 4 MB "token" isn't an event file
+			keep = end;
+		}
+		memmove(&buffer[0], &buffer[keep], carry);
+		position += keep;
+	}
+	fclose(f);
+	return true;
+}
+
+bool eventIndex::save(const char* dataPath) const {
+	//write under a temporary name and rename, so nodes sharing a filesystem never read a half written index
+	string path = sidecarPath(dataPath);
+	char suffix[32];
+	sprintf(suffix, ".%d", (int)getpid());
+	string temp = path + suffix;
+	FILE* f = fopen(temp.c_str(), "wb");
+	if(!f){
+		return false;
+	}
+	eventIndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, eventIndexMagic, 4);
+	header.version = eventIndexVersion;
+	header.dataSize = dataSize;
+	header.dataTime = dataTime;
+	header.numEvents = entries.size();
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+		&& (entries.empty() || fwrite(&entries[0], sizeof(eventIndexEntry), entries.size(), f) == entries.size());
+	ok = fclose(f) == 0 && ok;
+#ifdef _WIN32
+	remove(path.c_str());  //rename won't replace an existing file on Windows
+#endif
+	if(!ok || rename(temp.c_str(), path.c_str()) != 0){
+		remove(temp.c_str());
+		return false;
+	}
+	return true;
+}
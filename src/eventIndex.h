@@ -0,0 +1,50 @@
+//********************************************************
+// Sidecar index for text event files.
+//
+// <datafile>.hkidx holds the byte offset of every event (the
+// position just after the previous NEXTEVENT), its end time and
+// its hit counts.  It is built once by a fast scan of the text
+// and reused as long as the data file's size and modification
+// time still match, so reaching any event is one seek plus one
+// event parse.
+//********************************************************
+
+#ifndef EVENTINDEX_H
+#define EVENTINDEX_H
+
+#include <string>
+#include <vector>
+#include "eventData.h"
+
+static const char eventIndexMagic[4] = { 'H', 'K', 'I', 'X' };
+static const hkUint32 eventIndexVersion = 1;
+
+struct eventIndexEntry {
+	hkUint64 offset;
+	double endTime;
+	hkUint32 numHits;
+	hkUint32 numOuterHits;
+};
+
+class eventIndex {
+public:
+	// loads the sidecar if it matches the data file, otherwise scans the data file and writes a new sidecar
+	bool open(const char* dataPath);
+	bool load(const char* dataPath);
+	bool build(const char* dataPath);
+	// failing to save (eg, a read-only data directory) is harmless, the index is just rebuilt next time
+	bool save(const char* dataPath) const;
+
+	size_t size() const { return entries.size(); }
+	const eventIndexEntry& operator[](size_t i) const { return entries[i]; }
+	bool wasRebuilt() const { return rebuilt; }
+
+	static std::string sidecarPath(const char* dataPath);
+private:
+	std::vector<eventIndexEntry> entries;
+	hkUint64 dataSize;
+	hkUint64 dataTime;
+	bool rebuilt;
+};
+
+#endif
@@ -0,0 +1,349 @@
+//********************************************************
+// Text event parser.  See eventParser.h.
+//********************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "eventParser.h"
+
+using namespace std;
+
+string parseStats::report() const {
+	char text[200];
+	double megabytes = bytes / 1048576.0;
+	double s = seconds > 0 ? seconds : 1e-9;
+	sprintf(text, "parsed %.1f MB, %lu events, %lu hits in %.2f s (%.1f MB/s, %.0f hits/s)",
+		megabytes, (unsigned long)events, (unsigned long)hits, seconds, megabytes / s, hits / s);
+	string r = text;
+	if(threads > 1){
+		sprintf(text, " on %u threads", threads);
+		r += text;
+	}
+	return r;
+}
+
+double parseClock(){
+	return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the same characters istream >> skips
+static inline bool isSpace(char c){
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+static inline bool isDigit(char c){
+	return c >= '0' && c <= '9';
+}
+
+// every power of ten a double holds exactly
+static const double exactPowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+eventParser::eventParser(const char* b, const char* e) : begin(b), p(b), end(e), bad(false) {
+}
+
+void eventParser::skipSpace(){
+	while(p < end && isSpace(*p)){
+		p++;
+	}
+}
+
+bool eventParser::token(const char*& start, size_t& length){
+	skipSpace();
+	if(p == end){
+		return false;
+	}
+	start = p;
+	while(p < end && !isSpace(*p)){
+		p++;
+	}
+	length = p - start;
+	return true;
+}
+
+/* Reads a decimal number.  The digits are gathered in to a 64 bit integer, and when both it and the power of ten are
+exactly representable (the data files' usual handful of digits) one multiply or divide gives the correctly rounded
+double, the same one strtod would give.  Anything longer goes to strtod itself, so the result never differs. */
+bool eventParser::number(double& value){
+	skipSpace();
+	const char* start = p;
+	const char* c = p;
+	bool negative = false;
+	if(c < end && (*c == '-' || *c == '+')){
+		negative = *c == '-';
+		c++;
+	}
+	hkUint64 mantissa = 0;
+	int significant = 0;
+	int exponent = 0;
+	bool anyDigits = false;
+	bool exact = true;
+	for(; c < end && isDigit(*c); c++){
+		anyDigits = true;
+		if(mantissa > 0 || *c != '0'){
+			if(++significant > 19) exact = false;
+			mantissa = mantissa * 10 + (*c - '0');
+		}
+	}
+	if(c < end && *c == '.'){
+		for(c++; c < end && isDigit(*c); c++){
+			anyDigits = true;
+			exponent--;
+			if(mantissa > 0 || *c != '0'){
+				if(++significant > 19) exact = false;
+				mantissa = mantissa * 10 + (*c - '0');
+			}
+		}
+	}
+	if(!anyDigits){
+		return false;
+	}
+	if(c < end && (*c == 'e' || *c == 'E')){
+		//only an exponent if digits follow, otherwise the 'e' is left alone like strtod does
+		const char* e = c + 1;
+		bool negativeExponent = false;
+		if(e < end && (*e == '-' || *e == '+')){
+			negativeExponent = *e == '-';
+			e++;
+		}
+		if(e < end && isDigit(*e)){
+			int written = 0;
+			for(; e < end && isDigit(*e); e++){
+				if(written < 100000) written = written * 10 + (*e - '0');
+			}
+			exponent += negativeExponent ? -written : written;
+			c = e;
+		}
+	}
+	p = c;
+
+	if(exact && mantissa <= (hkUint64(1) << 53) && exponent >= -22 && exponent <= 22){
+		value = (double)mantissa;
+		if(exponent > 0){
+			value *= exactPowersOfTen[exponent];
+		}
+		else if(exponent < 0){
+			value /= exactPowersOfTen[-exponent];
+		}
+		if(negative){
+			value = -value;
+		}
+		return true;
+	}
+	char text[128];
+	size_t length = c - start;
+	if(length >= sizeof(text)){
+		return false;
+	}
+	memcpy(text, start, length);
+	text[length] = 0;
+	value = strtod(text, 0);
+	return true;
+}
+
+bool eventParser::integer(int& value){
+	skipSpace();
+	bool negative = false;
+	if(p < end && (*p == '-' || *p == '+')){
+		negative = *p == '-';
+		p++;
+	}
+	if(p == end || !isDigit(*p)){
+		return false;
+	}
+	long long v = 0;
+	for(; p < end && isDigit(*p); p++){
+		v = v * 10 + (*p - '0');
+	}
+	value = (int)(negative ? -v : v);
+	return true;
+}
+
+//the fields after ID / OD: filler, hit number, x y z, direction xyz, charge, time
+bool eventParser::hitLine(int& hit, double* values){
+	double filler;
+	if(!number(filler) || !integer(hit)){
+		return false;
+	}
+	for(int k = 0; k < 8; k++){
+		if(!number(values[k])){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool eventParser::loadNextEvent(dotVector& event, double startTime){
+	double time = 0;
+	double vx = 0, vy = 0, vz = 0;
+	int hit;
+	double v[8];  //x y z xd yd zd q t
+	double particle[6];  //type, direction xyz, momentum, id
+	const char* t;
+	size_t length;
+	event.dots.clear();
+	event.outerDots.clear();
+	while(token(t, length)){
+		switch(t[0]){
+		case 'I':  //parse inner detector
+			if(length == 2 && t[1] == 'D'){
+				if(!hitLine(hit, v)) break;
+				event.dots.push_back(hit, (float)(v[0] * 3.28), (float)(v[1] * 3.28), (float)(v[2] * 3.28), (float)v[3], (float)v[4], (float)v[5], (float)v[6], (float)v[7]);
+				counts.hits++;
+			}
+			continue;
+		case 'O':  //parse outer detector
+			if(length == 2 && t[1] == 'D'){
+				if(!hitLine(hit, v)) break;
+				double x = v[0] / 100.0;
+				double y = v[1] / 100.0;
+				double z = v[2] * 20.0 / 1810.0 + 20.0;
+				event.outerDots.push_back(hit, (float)(x * 3.28), (float)(y * 3.28), (float)(z * 3.28), (float)v[3], (float)v[4], (float)v[5], (float)v[6], (float)v[7]);
+				counts.hits++;
+			}
+			continue;
+		case 'T':  //parse time info
+			if(length == 4 && memcmp(t, "TIME", 4) == 0){
+				if(!number(time)) break;
+			}
+			continue;
+		case 'V':  //vertex location of particle
+			if(length == 6 && memcmp(t, "VERTEX", 6) == 0){
+				if(!number(vx) || !number(vy) || !number(vz)) break;
+				vx = vx / 100 * 3.28;
+				vy = vy / 100 * 3.28;
+				vz = vz * 20.0 / 1810.0 + 20.0;
+				vz = vz * 3.28;
+			}
+			continue;
+		case 'P':  //particle information -- momentum and direction of cone
+			if(length == 8 && memcmp(t, "PARTICLE", 8) == 0){
+				bool ok = true;
+				for(int k = 0; ok && k < 6; k++){
+					ok = number(particle[k]);
+				}
+				if(!ok) break;
+				addParticle(event, particle[0], particle[1], particle[2], particle[3], particle[4]);
+			}
+			continue;
+		case 'N':  //store everything, the next event starts after this
+			if(length == 9 && memcmp(t, "NEXTEVENT", 9) == 0){
+				event.endTime = time;
+				event.vertexPosition[0] = vx;
+				event.vertexPosition[1] = vy;
+				event.vertexPosition[2] = vz;
+				//the START TIME is the END TIME of the previous event (0 for the first, so length is 'time')
+				event.startTime = startTime;
+				event.length = time - event.startTime;
+				computeConePhysics(event);
+				counts.events++;
+				counts.bytes = p - begin;
+				return true;
+			}
+			continue;
+		default:  //anything else is skipped, as it always has been
+			continue;
+		}
+		bad = true;  //a malformed number ends the file, as a failed >> did
+		break;
+	}
+	counts.bytes = p - begin;
+	return false;
+}
+
+//position just past the first NEXTEVENT keyword at or after 'from', or 'end' if there isn't one
+static const char* afterNextEvent(const char* begin, const char* from, const char* end){
+	while(from < end){
+		const char* n = (const char*)memchr(from, 'N', end - from);
+		if(!n){
+			break;
+		}
+		if(end - n >= 9 && memcmp(n, "NEXTEVENT", 9) == 0 && (n == begin || isSpace(n[-1])) && (n + 9 == end || isSpace(n[9]))){
+			return n + 9;
+		}
+		from = n + 1;
+	}
+	return end;
+}
+
+//one piece of the buffer for parseEvents
+struct parseChunk {
+	const char* begin;
+	const char* end;
+	vector<dotVector> events;
+	parseStats stats;
+	bool malformed;
+	void run(){
+		eventParser parser(begin, end);
+		events.push_back(dotVector());
+		while(parser.loadNextEvent(events.back(), 0)){
+			events.push_back(dotVector());
+		}
+		events.pop_back();
+		stats = parser.stats();
+		malformed = parser.malformed();
+	}
+};
+
+parseStats parseEvents(const char* begin, const char* end, vector<dotVector>& events, double startTime, unsigned threads){
+	double started = parseClock();
+	if(threads == 0){
+		threads = thread::hardware_concurrency();
+	}
+	//pieces under a few MB aren't worth a thread
+	size_t minimumChunk = 4 << 20;
+	size_t pieces = (end - begin) / minimumChunk;
+	if(pieces > threads) pieces = threads;
+	if(pieces < 1) pieces = 1;
+
+	vector<parseChunk> chunks(pieces);
+	const char* from = begin;
+	for(size_t k = 0; k < pieces; k++){
+		chunks[k].begin = from;
+		chunks[k].end = k + 1 == pieces ? end : afterNextEvent(begin, begin + (end - begin) * (k + 1) / pieces, end);
+		if(chunks[k].end < from){
+			chunks[k].end = from;
+		}
+		from = chunks[k].end;
+	}
+	vector<thread> workers;
+	for(size_t k = 1; k < pieces; k++){
+		workers.push_back(thread(&parseChunk::run, &chunks[k]));
+	}
+	chunks[0].run();
+	for(size_t k = 0; k < workers.size(); k++){
+		workers[k].join();
+	}
+
+	//stitch the pieces together in order, chaining the start times
+	parseStats total;
+	total.threads = (unsigned)pieces;
+	size_t count = 0;
+	for(size_t k = 0; k < pieces; k++){
+		count += chunks[k].events.size();
+	}
+	events.reserve(events.size() + count);
+	for(size_t k = 0; k < pieces; k++){
+		parseChunk& c = chunks[k];
+		for(size_t i = 0; i < c.events.size(); i++){
+			events.push_back(std::move(c.events[i]));
+			dotVector& e = events.back();
+			e.startTime = startTime;
+			e.length = e.endTime - e.startTime;
+			startTime = e.endTime;
+		}
+		total.bytes += c.stats.bytes;
+		total.events += c.stats.events;
+		total.hits += c.stats.hits;
+		if(c.malformed){
+			break;  //a single parser would have stopped here too
+		}
+	}
+	total.seconds = parseClock() - started;
+	return total;
+}
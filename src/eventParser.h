@@ -0,0 +1,65 @@
+//********************************************************
+// Parser for the text event format (ID/OD/TIME/VERTEX/
+// PARTICLE/NEXTEVENT lines).
+//
+// Works straight off a buffer, normally a mapped file, with
+// no stream or per-token string: keywords are told apart by
+// their first byte and numbers are converted in place, to
+// exactly the doubles istream >> would give.
+//********************************************************
+
+#ifndef EVENTPARSER_H
+#define EVENTPARSER_H
+
+#include <string>
+#include <vector>
+#include "eventData.h"
+
+// parse throughput, for the load time report
+struct parseStats {
+	hkUint64 bytes;
+	hkUint64 events;
+	hkUint64 hits;  //ID and OD
+	double seconds;
+	unsigned threads;
+	parseStats() : bytes(0), events(0), hits(0), seconds(0), threads(1) {}
+	// eg "parsed 35.6 MB, 20000 events, 450123 hits in 0.41 s (86.8 MB/s, 1097861 hits/s) on 8 threads"
+	std::string report() const;
+};
+
+// wall clock seconds, for timing loads
+double parseClock();
+
+class eventParser {
+public:
+	eventParser(const char* begin, const char* end);
+	/* logic to fill a dotVector.  Parses from the buffer and populates 'event' until it hits a NEXTEVENT line, where
+	it stores the event and returns true.  'startTime' is the endTime of the event before this one (0 for the first).
+	Returns false once the buffer runs out before another NEXTEVENT, or on a malformed number. */
+	bool loadNextEvent(dotVector& event, double startTime);
+	const char* position() const { return p; }
+	// bytes, events and hits parsed so far.  seconds is left for the caller to fill in.
+	const parseStats& stats() const { return counts; }
+	// true if parsing stopped on a malformed number rather than at the end of the buffer
+	bool malformed() const { return bad; }
+private:
+	void skipSpace();
+	bool token(const char*& start, size_t& length);
+	bool number(double& value);
+	bool integer(int& value);
+	bool hitLine(int& hit, double* values);
+
+	const char* begin;
+	const char* p;
+	const char* end;
+	parseStats counts;
+	bool bad;
+};
+
+/* Parses every event in [begin, end) and appends them to 'events'.  The buffer is cut in to pieces at NEXTEVENT lines
+and the pieces are parsed on 'threads' threads at once (0 for one per core), then a quick pass in order chains each
+event's startTime off the endTime before it.  The result is the same as one eventParser run over the whole buffer.
+'startTime' is the endTime of the event before the first one.  The returned stats include the wall clock time. */
+parseStats parseEvents(const char* begin, const char* end, std::vector<dotVector>& events, double startTime, unsigned threads = 0);
+
+#endif
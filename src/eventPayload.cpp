@@ -0,0 +1,416 @@
+//********************************************************
+// Master to slave event transfer.  See eventPayload.h.
+//********************************************************
+
+#include <string.h>
+#include "eventPayload.h"
+
+using namespace std;
+
+// everything in a payload ahead of the particles and hits
+struct payloadHeader {
+	double startTime;
+	double endTime;
+	double length;
+	double vertexPosition[3];
+	hkUint32 numHits;
+	hkUint32 numOuterHits;
+	hkUint32 numParticles;
+	hkUint32 reserved;
+};
+
+struct payloadParticle {
+	double type;
+	double direction[3];
+	double momentum;
+	double energy;
+	double coneAngle;
+	hkUint32 display;
+	hkUint32 reserved;
+};
+
+// ahead of each piece of an event in a frame's message, which starts with the event count (hkUint64) and the
+// number of chunks (hkUint32)
+struct payloadChunk {
+	hkUint64 event;
+	hkUint32 total;   //bytes in the event's whole payload
+	hkUint32 offset;  //where this piece goes in it
+	hkUint32 bytes;
+	hkUint32 reserved;
+};
+
+static void put(vector<char>& out, const void* data, size_t bytes){
+	const char* p = (const char*)data;
+	out.insert(out.end(), p, p + bytes);
+}
+
+static void putVarint(vector<char>& out, hkUint64 value){
+	while(value >= 0x80){
+		out.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+// reads a payload or a message front to back, failing rather than running off the end
+struct payloadReader {
+	const char* at;
+	const char* end;
+	payloadReader(const char* data, size_t size) : at(data), end(data + size) {}
+	bool get(void* data, size_t bytes){
+		if((size_t)(end - at) < bytes){
+			return false;
+		}
+		memcpy(data, at, bytes);
+		at += bytes;
+		return true;
+	}
+	const char* take(size_t bytes){
+		if((size_t)(end - at) < bytes){
+			return 0;
+		}
+		const char* data = at;
+		at += bytes;
+		return data;
+	}
+	bool getVarint(hkUint64& value){
+		value = 0;
+		for(int shift = 0; shift < 64 && at < end; shift += 7){
+			unsigned char b = (unsigned char)*at++;
+			value |= (hkUint64)(b & 0x7f) << shift;
+			if(!(b & 0x80)){
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+// PMT numbers mostly climb in small steps, so they go as the zigzagged difference from the one before
+static void putNumbers(vector<char>& out, const hkUint32* number, size_t n){
+	hkUint32 previous = 0;
+	for(size_t i = 0; i < n; i++){
+		long long step = (long long)number[i] - (long long)previous;
+		putVarint(out, step < 0 ? ((hkUint64)(-step) << 1) - 1 : (hkUint64)step << 1);
+		previous = number[i];
+	}
+}
+
+static bool getNumbers(payloadReader& in, vector<hkUint32>& number, size_t n){
+	number.resize(n);
+	hkUint32 previous = 0;
+	for(size_t i = 0; i < n; i++){
+		hkUint64 zigzag;
+		if(!in.getVarint(zigzag)){
+			return false;
+		}
+		long long step = zigzag & 1 ? -(long long)((zigzag + 1) >> 1) : (long long)(zigzag >> 1);
+		previous = number[i] = (hkUint32)(previous + step);
+	}
+	return true;
+}
+
+/* Neighbouring hits are often on the same ring or wall, so a position or direction tends to share its sign, exponent
+and top bits with the one before, and XORing them leaves mostly zeros.  Those zeros gather in the high byte planes,
+where each run of them is sent as a 0 and its length. */
+static void putFloats(vector<char>& out, const float* values, size_t n, vector<hkUint32>& scratch){
+	scratch.resize(n);
+	hkUint32 previous = 0;
+	for(size_t i = 0; i < n; i++){
+		hkUint32 bits;
+		memcpy(&bits, &values[i], sizeof(bits));
+		scratch[i] = bits ^ previous;
+		previous = bits;
+	}
+	for(int plane = 0; plane < 4; plane++){
+		size_t zeros = 0;
+		for(size_t i = 0; i < n; i++){
+			char b = (char)(scratch[i] >> (8 * plane));
+			if(b == 0){
+				zeros++;
+				continue;
+			}
+			if(zeros){
+				out.push_back(0);
+				putVarint(out, zeros);
+				zeros = 0;
+			}
+			out.push_back(b);
+		}
+		if(zeros){
+			out.push_back(0);
+			putVarint(out, zeros);
+		}
+	}
+}
+
+static bool getFloats(payloadReader& in, vector<float>& values, size_t n, vector<hkUint32>& scratch){
+	scratch.assign(n, 0);
+	for(int plane = 0; plane < 4; plane++){
+		for(size_t i = 0; i < n; ){
+			unsigned char b;
+			if(!in.get(&b, 1)){
+				return false;
+			}
+			if(b != 0){
+				scratch[i++] |= (hkUint32)b << (8 * plane);
+				continue;
+			}
+			hkUint64 zeros;
+			if(!in.getVarint(zeros) || zeros == 0 || zeros > n - i){
+				return false;
+			}
+			i += (size_t)zeros;
+		}
+	}
+	values.resize(n);
+	hkUint32 previous = 0;
+	for(size_t i = 0; i < n; i++){
+		previous ^= scratch[i];
+		memcpy(&values[i], &previous, sizeof(previous));
+	}
+	return true;
+}
+
+static void putHits(vector<char>& out, const hitColumnsView& hits, vector<hkUint32>& scratch){
+	putNumbers(out, hits.number, hits.count);
+	const float* columns[] = { hits.cx, hits.cy, hits.cz, hits.dx, hits.dy, hits.dz, hits.charge, hits.time };
+	for(int c = 0; c < 8; c++){
+		putFloats(out, columns[c], hits.count, scratch);
+	}
+}
+
+static bool getHits(payloadReader& in, hitColumns& hits, size_t n, vector<hkUint32>& scratch){
+	vector<float>* columns[] = { &hits.cx, &hits.cy, &hits.cz, &hits.dx, &hits.dy, &hits.dz, &hits.charge, &hits.time };
+	if(!getNumbers(in, hits.number, n)){
+		return false;
+	}
+	for(int c = 0; c < 8; c++){
+		if(!getFloats(in, *columns[c], n, scratch)){
+			return false;
+		}
+	}
+	return true;
+}
+
+void encodeEvent(const dotVector& event, vector<char>& payload){
+	hitColumnsView inner = event.innerHits();
+	hitColumnsView outer = event.outerHits();
+	payloadHeader header;
+	memset(&header, 0, sizeof(header));
+	header.startTime = event.startTime;
+	header.endTime = event.endTime;
+	header.length = event.length;
+	for(int k = 0; k < 3; k++){
+		header.vertexPosition[k] = event.vertexPosition[k];
+	}
+	header.numHits = (hkUint32)inner.count;
+	header.numOuterHits = (hkUint32)outer.count;
+	header.numParticles = (hkUint32)event.particleType.size();
+	put(payload, &header, sizeof(header));
+	for(size_t p = 0; p < event.particleType.size(); p++){
+		payloadParticle particle;
+		memset(&particle, 0, sizeof(particle));
+		particle.type = event.particleType[p];
+		for(int k = 0; k < 3; k++){
+			particle.direction[k] = event.coneDirection[p][k];
+		}
+		particle.momentum = event.momentum[p];
+		particle.energy = event.energy[p];
+		particle.coneAngle = event.coneAngle[p];
+		particle.display = event.doDisplay[p];
+		put(payload, &particle, sizeof(particle));
+	}
+	vector<hkUint32> scratch;
+	putHits(payload, inner, scratch);
+	putHits(payload, outer, scratch);
+}
+
+bool decodeEvent(const char* payload, size_t size, dotVector& event){
+	payloadReader in(payload, size);
+	payloadHeader header;
+	if(!in.get(&header, sizeof(header))){
+		return false;
+	}
+	event.startTime = header.startTime;
+	event.endTime = header.endTime;
+	event.length = header.length;
+	for(int k = 0; k < 3; k++){
+		event.vertexPosition[k] = header.vertexPosition[k];
+	}
+	for(hkUint32 p = 0; p < header.numParticles; p++){
+		payloadParticle particle;
+		if(!in.get(&particle, sizeof(particle))){
+			return false;
+		}
+		event.particleType.push_back(particle.type);
+		event.coneDirection.push_back(vec3((float)particle.direction[0], (float)particle.direction[1], (float)particle.direction[2]));
+		event.momentum.push_back(particle.momentum);
+		event.energy.push_back(particle.energy);
+		event.coneAngle.push_back(particle.coneAngle);
+		addParticleDisplayState(event);
+		event.doDisplay.back() = particle.display != 0;
+	}
+	vector<hkUint32> scratch;
+	return getHits(in, event.dots, header.numHits, scratch) && getHits(in, event.outerDots, header.numOuterHits, scratch);
+}
+
+// enough for the window either side and as much again, so stepping back and forth doesn't send anything twice
+static size_t heldCapacity(size_t window){
+	return 2 * (2 * window + 1);
+}
+
+heldEvents::heldEvents(size_t c) : capacity(c) {
+}
+
+bool heldEvents::add(size_t event, size_t current, size_t& evicted){
+	if(!events.insert(event).second || events.size() <= capacity){
+		return false;
+	}
+	//ties go to the later event
+	size_t furthest = 0, distance = 0;
+	for(set<size_t>::const_iterator e = events.begin(); e != events.end(); ++e){
+		size_t d = *e > current ? *e - current : current - *e;
+		if(d >= distance){
+			furthest = *e;
+			distance = d;
+		}
+	}
+	events.erase(furthest);
+	evicted = furthest;
+	return true;
+}
+
+void eventsAround(size_t index, size_t numEvents, size_t window, vector<size_t>& wanted){
+	wanted.clear();
+	if(index >= numEvents){
+		return;
+	}
+	wanted.push_back(index);
+	for(size_t d = 1; d <= window; d++){
+		if(index + d < numEvents){
+			wanted.push_back(index + d);
+		}
+		if(index >= d){
+			wanted.push_back(index - d);
+		}
+	}
+}
+
+eventSender::eventSender(size_t w, size_t f, int r) : window(w), frameBytes(f), refreshFrames(r), sinceRefresh(0),
+	generation(0), slaves(heldCapacity(w)), sending(false), sendingEvent(0), done(0) {
+}
+
+void eventSender::frame(size_t index, size_t numEvents, dotVector& (*eventAt)(size_t), vector<char>& message){
+	if(++sinceRefresh >= refreshFrames){
+		sinceRefresh = 0;
+		generation++;
+		slaves.clear();
+	}
+	message.clear();
+	hkUint64 count = numEvents;
+	hkUint32 chunks = 0;
+	put(message, &count, sizeof(count));
+	put(message, &generation, sizeof(generation));
+	put(message, &chunks, sizeof(chunks));
+	eventsAround(index, numEvents, window, wanted);
+	size_t budget = frameBytes;
+	for(size_t w = 0; w < wanted.size() && budget > sizeof(payloadChunk); ){
+		size_t next = wanted[w];
+		if(slaves.has(next)){
+			w++;
+			continue;
+		}
+		//a more wanted event cuts in ahead of one half sent, which the slaves then drop
+		if(!sending || sendingEvent != next){
+			payload.clear();
+			encodeEvent(eventAt(next), payload);
+			sending = true;
+			sendingEvent = next;
+			done = 0;
+		}
+		payloadChunk chunk;
+		memset(&chunk, 0, sizeof(chunk));
+		chunk.event = next;
+		chunk.total = (hkUint32)payload.size();
+		chunk.offset = (hkUint32)done;
+		chunk.bytes = (hkUint32)min(payload.size() - done, budget - sizeof(payloadChunk));
+		put(message, &chunk, sizeof(chunk));
+		put(message, &payload[done], chunk.bytes);
+		done += chunk.bytes;
+		budget -= sizeof(payloadChunk) + chunk.bytes;
+		chunks++;
+		if(done == payload.size()){
+			size_t evicted;
+			slaves.add(next, index, evicted);
+			sending = false;
+		}
+	}
+	memcpy(&message[sizeof(count) + sizeof(generation)], &chunks, sizeof(chunks));
+}
+
+eventReceiver::eventReceiver(size_t window) : numEvents(0), started(false), generation(0), held(heldCapacity(window)),
+	assembling(false), assemblingEvent(0) {
+}
+
+void eventReceiver::receive(const char* message, size_t size, size_t index){
+	payloadReader in(message, size);
+	hkUint64 count;
+	hkUint32 messageGeneration, chunks;
+	if(!in.get(&count, sizeof(count)) || !in.get(&messageGeneration, sizeof(messageGeneration)) || !in.get(&chunks, sizeof(chunks))){
+		return;
+	}
+	numEvents = (size_t)count;
+	//a new generation: forget what's held, as the master has, dropping what wasn't sent again in the last one
+	if(!started || messageGeneration != generation){
+		for(set<size_t>::const_iterator e = stale.begin(); e != stale.end(); ++e){
+			events.erase(*e);
+		}
+		stale.clear();
+		for(map<size_t, dotVector>::const_iterator e = events.begin(); e != events.end(); ++e){
+			stale.insert(e->first);
+		}
+		held.clear();
+		started = true;
+		generation = messageGeneration;
+	}
+	for(hkUint32 c = 0; c < chunks; c++){
+		payloadChunk chunk;
+		const char* data;
+		if(!in.get(&chunk, sizeof(chunk)) || !(data = in.take(chunk.bytes))){
+			return;
+		}
+		if(chunk.offset == 0){
+			assembling = true;
+			assemblingEvent = (size_t)chunk.event;
+			payload.clear();
+		}
+		else if(!assembling || assemblingEvent != chunk.event || payload.size() != chunk.offset){
+			assembling = false;  //the master moved on to another event part way through this one
+			continue;
+		}
+		payload.insert(payload.end(), data, data + chunk.bytes);
+		if(payload.size() < chunk.total){
+			continue;
+		}
+		//held even if it's corrupt, so the master and this slave keep agreeing on what's here.  One kept from the last
+		//generation is the same event, so it stays as it is, and where it is.
+		assembling = false;
+		if(!stale.erase(assemblingEvent)){
+			dotVector& event = events[assemblingEvent];
+			event = dotVector();
+			if(!decodeEvent(&payload[0], payload.size(), event)){
+				event = dotVector();
+			}
+		}
+		size_t evicted;
+		if(held.add(assemblingEvent, index, evicted)){
+			events.erase(evicted);
+		}
+	}
+}
+
+dotVector& eventReceiver::get(size_t i){
+	map<size_t, dotVector>::iterator e = events.find(i);
+	return e == events.end() ? missing : e->second;
+}
@@ -0,0 +1,102 @@
+//********************************************************
+// Events sent from the master to the slaves.
+//
+// With -distribute, only the master reads the event file.
+// Each frame it packs the events around the current one that
+// the slaves don't have yet in to one message, which goes out
+// over the master/slave channel with the rest of the transfer
+// fields, cut in to chunks so no frame carries more than a set
+// number of bytes.  An event travels as a payload: its header
+// and particles as they are, then its hit columns, each one
+// XORed with the value before, split in to byte planes and
+// with runs of zero bytes shortened to a count.
+//
+// The slaves keep what they're sent, evicting the event
+// furthest from the current one once they hold enough.  The
+// master runs the same bookkeeping over the same events in the
+// same frames, so it always knows what the slaves have without
+// hearing back from them.  A slave that starts late (or comes
+// back) has missed some of that, so every so often the master
+// forgets what it's sent and starts a new generation, which
+// the slaves see in the message and do the same, and the
+// window is sent again.  Slaves keep showing the events they
+// have meanwhile.  Messages are in the master's byte order,
+// so every node has to share it.
+//********************************************************
+
+#ifndef EVENTPAYLOAD_H
+#define EVENTPAYLOAD_H
+
+#include <stddef.h>
+#include <map>
+#include <set>
+#include <vector>
+#include "eventData.h"
+
+// appends event to 'payload', ready for decodeEvent
+void encodeEvent(const dotVector& event, std::vector<char>& payload);
+// rebuilds an event from a payload, the hits in to its own columns.  False if the payload is malformed.
+bool decodeEvent(const char* payload, size_t size, dotVector& event);
+
+// Which events a slave holds.  Adding one past 'capacity' evicts the held event furthest from the current one.
+class heldEvents {
+public:
+	heldEvents(size_t capacity);
+	bool has(size_t event) const { return events.count(event) != 0; }
+	// adds 'event', putting the event it evicts (if any) in 'evicted'
+	bool add(size_t event, size_t current, size_t& evicted);
+	void clear(){ events.clear(); }
+private:
+	size_t capacity;
+	std::set<size_t> events;
+};
+
+// the events around 'index', in the order they're wanted: index, index + 1, index - 1, index + 2 ...
+void eventsAround(size_t index, size_t numEvents, size_t window, std::vector<size_t>& wanted);
+
+// The master's side.  The events themselves come from the caller, who can fetch any of them.
+class eventSender {
+public:
+	// keeps 'window' events either side of the current one on the slaves, sending at most 'frameBytes' a frame and
+	// starting a new generation every 'refreshFrames' frames
+	eventSender(size_t window, size_t frameBytes, int refreshFrames);
+	// packs this frame's message for when the current event is 'index', encoding events fetched with eventAt
+	void frame(size_t index, size_t numEvents, dotVector& (*eventAt)(size_t), std::vector<char>& message);
+private:
+	size_t window;
+	size_t frameBytes;
+	int refreshFrames;
+	int sinceRefresh;
+	hkUint32 generation;
+	heldEvents slaves;
+	std::vector<size_t> wanted;
+	bool sending;
+	size_t sendingEvent;
+	std::vector<char> payload;  //sendingEvent's, 'done' bytes of it already sent
+	size_t done;
+};
+
+// A slave's side.  Events that haven't arrived come back empty.
+class eventReceiver {
+public:
+	eventReceiver(size_t window);
+	// unpacks this frame's message, 'index' being the current event as of the same frame
+	void receive(const char* message, size_t size, size_t index);
+	size_t size() const { return numEvents; }
+	bool has(size_t event) const { return events.count(event) != 0; }
+	// event i, or an empty one if it's not here (yet).  The reference is good until the next receive().
+	dotVector& get(size_t i);
+private:
+	size_t numEvents;
+	bool started;
+	hkUint32 generation;
+	heldEvents held;
+	std::map<size_t, dotVector> events;
+	std::set<size_t> stale;  //events kept from the last generation that haven't been sent again in this one
+	dotVector missing;
+	bool assembling;
+	size_t assemblingEvent;
+	std::vector<char> payload;
+};
+
+#endif
@@ -0,0 +1,134 @@
+//********************************************************
+// Frame phase timing.  See frameTimer.h.
+//********************************************************
+
+#include "frameTimer.h"
+
+#ifdef HK_PROFILE
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+static const char* phaseNames[NUM_FRAME_PHASES] = {
+	"preExchange", "postExchange", "display", "drawDots", "drawDetector", "drawEffector"
+};
+
+struct timerSample {
+	float start;  //ms since the process' first sample
+	float milliseconds;
+	int phase;
+};
+
+// One thread's samples.  Only that thread writes, and 'written' is stored after the sample, so a reader sees whole
+// samples (unless the writer has gone all the way round the ring since, which 'size' makes unlikely).
+struct timerRing {
+	enum { SIZE = 1 << 14 };
+	timerSample samples[SIZE];
+	atomic<size_t> written;
+	int thread;
+	timerRing() : written(0), thread(0) {}
+};
+
+static mutex ringsLock;
+static vector<timerRing*> rings;  //every thread's, never freed so the readers needn't worry about threads ending
+static thread_local timerRing* threadRing = 0;
+
+static const chrono::steady_clock::time_point firstSample = chrono::steady_clock::now();
+
+const char* frameTimes::name(int phase){
+	return phase >= 0 && phase < NUM_FRAME_PHASES ? phaseNames[phase] : "?";
+}
+
+double frameTimes::now(){
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - firstSample).count();
+}
+
+void frameTimes::record(int phase, double start, double milliseconds){
+	if(!threadRing){
+		threadRing = new timerRing;
+		lock_guard<mutex> lock(ringsLock);
+		threadRing->thread = (int)rings.size();
+		rings.push_back(threadRing);
+	}
+	size_t n = threadRing->written.load(memory_order_relaxed);
+	timerSample& sample = threadRing->samples[n % timerRing::SIZE];
+	sample.start = (float)start;
+	sample.milliseconds = (float)milliseconds;
+	sample.phase = phase;
+	threadRing->written.store(n + 1, memory_order_release);
+}
+
+// the phase's last 'samples' durations from every ring
+static void collect(int phase, size_t samples, vector<float>& out){
+	out.clear();
+	lock_guard<mutex> lock(ringsLock);
+	for(size_t r = 0; r < rings.size(); r++){
+		size_t written = rings[r]->written.load(memory_order_acquire);
+		size_t held = min(written, (size_t)timerRing::SIZE);
+		size_t found = 0;
+		for(size_t k = 0; k < held && found < samples; k++){
+			const timerSample& sample = rings[r]->samples[(written - 1 - k) % timerRing::SIZE];
+			if(sample.phase == phase){
+				out.push_back(sample.milliseconds);
+				found++;
+			}
+		}
+	}
+}
+
+static float percentile(vector<float>& values, double p){
+	size_t k = (size_t)(p * (values.size() - 1) + .5);
+	nth_element(values.begin(), values.begin() + k, values.end());
+	return values[k];
+}
+
+bool frameTimes::percentiles(int phase, size_t samples, double& p50, double& p95, double& p99){
+	vector<float> values;
+	collect(phase, samples, values);
+	if(values.empty()){
+		return false;
+	}
+	p50 = percentile(values, .50);
+	p95 = percentile(values, .95);
+	p99 = percentile(values, .99);
+	return true;
+}
+
+string frameTimes::report(size_t samples){
+	string text;
+	for(int phase = 0; phase < NUM_FRAME_PHASES; phase++){
+		double p50, p95, p99;
+		if(!percentiles(phase, samples, p50, p95, p99)){
+			continue;
+		}
+		char line[128];
+		sprintf(line, "%s %.2f %.2f %.2f\n", name(phase), p50, p95, p99);
+		text += line;
+	}
+	return text;
+}
+
+bool frameTimes::writeCsv(const char* path){
+	FILE* f = fopen(path, "w");
+	if(!f){
+		return false;
+	}
+	fprintf(f, "thread,phase,start_ms,duration_ms\n");
+	lock_guard<mutex> lock(ringsLock);
+	for(size_t r = 0; r < rings.size(); r++){
+		size_t written = rings[r]->written.load(memory_order_acquire);
+		size_t first = written > timerRing::SIZE ? written - timerRing::SIZE : 0;
+		for(size_t k = first; k < written; k++){
+			const timerSample& sample = rings[r]->samples[k % timerRing::SIZE];
+			fprintf(f, "%d,%s,%.3f,%.4f\n", rings[r]->thread, name(sample.phase), sample.start, sample.milliseconds);
+		}
+	}
+	return fclose(f) == 0;
+}
+
+#endif
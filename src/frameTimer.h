@@ -0,0 +1,68 @@
+//********************************************************
+// Where the frame time goes.
+//
+// HK_TIME_PHASE(PHASE_...) at the top of a block times the
+// block, and the duration goes in to a ring buffer belonging to
+// the thread that ran it, so timing costs two clock reads and
+// a store, with no locking.  frameTimes reports rolling
+// percentiles per phase from the last samples, and can write
+// every sample still in the rings to a CSV file.
+//
+// All of it is only built with HK_PROFILE defined (make
+// PROFILE=1).  Without it HK_TIME_PHASE expands to nothing and
+// this header declares nothing else.
+//********************************************************
+
+#ifndef FRAMETIMER_H
+#define FRAMETIMER_H
+
+#ifdef HK_PROFILE
+
+#include <chrono>
+#include <string>
+
+enum framePhase {
+	PHASE_PRE_EXCHANGE = 0,
+	PHASE_POST_EXCHANGE,
+	PHASE_DISPLAY,
+	PHASE_DRAW_DOTS,
+	PHASE_DRAW_DETECTOR,
+	PHASE_DRAW_EFFECTOR,
+	NUM_FRAME_PHASES
+};
+
+class frameTimes {
+public:
+	static const char* name(int phase);
+	// adds a sample to this thread's ring
+	static void record(int phase, double start, double milliseconds);
+	// milliseconds since the first sample of the process, the clock samples are stamped with
+	static double now();
+	// p50, p95 and p99 of the phase's last 'samples' durations across all threads.  False if it has none.
+	static bool percentiles(int phase, size_t samples, double& p50, double& p95, double& p99);
+	// one line per phase: name p50 p95 p99 in milliseconds
+	static std::string report(size_t samples);
+	// thread,phase,start_ms,duration_ms for every sample still held
+	static bool writeCsv(const char* path);
+};
+
+class phaseTimer {
+public:
+	phaseTimer(int p) : phase(p), start(frameTimes::now()) {}
+	~phaseTimer() { frameTimes::record(phase, start, frameTimes::now() - start); }
+private:
+	int phase;
+	double start;
+};
+
+#define HK_TIMER_NAME2(line) hkPhaseTimer##line
+#define HK_TIMER_NAME(line) HK_TIMER_NAME2(line)
+#define HK_TIME_PHASE(phase) phaseTimer HK_TIMER_NAME(__LINE__)(phase)
+
+#else
+
+#define HK_TIME_PHASE(phase)
+
+#endif
+
+#endif
@@ -0,0 +1,76 @@
+//********************************************************
+// OpenGL entry points.  See glEntryPoints.h.
+//********************************************************
+
+#include "arPrecompiled.h"
+#include <stdlib.h>
+#include <string.h>
+#include "arGlut.h"
+#include "glEntryPoints.h"
+
+#if defined(_WIN32)
+#define hkGetProcAddress(name) wglGetProcAddress(name)
+#define hkGetCurrentContext() wglGetCurrentContext()
+#elif defined(__APPLE__)
+#include <dlfcn.h>
+#include <OpenGL/OpenGL.h>
+#define hkGetProcAddress(name) dlsym(RTLD_DEFAULT, name)
+#define hkGetCurrentContext() CGLGetCurrentContext()
+#else
+#include <GL/glx.h>
+#define hkGetProcAddress(name) glXGetProcAddressARB((const GLubyte*)name)
+#define hkGetCurrentContext() glXGetCurrentContext()
+#endif
+
+glEntryPoints gl;
+
+template <class T> static bool lookUp(T& function, const char* name, const char* alternate = 0){
+	function = (T)hkGetProcAddress(name);
+	if(!function && alternate){
+		function = (T)hkGetProcAddress(alternate);
+	}
+	return function != 0;
+}
+
+const void* currentContext(){
+	return (const void*)hkGetCurrentContext();
+}
+
+bool contextHasVersion(int major, int minor){
+	const char* version = (const char*)glGetString(GL_VERSION);
+	int contextMajor = version ? atoi(version) : 0;
+	const char* dot = version ? strchr(version, '.') : 0;
+	int contextMinor = dot ? atoi(dot + 1) : 0;
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+bool loadBufferEntryPoints(){
+	return lookUp(gl.GenBuffers, "glGenBuffers")
+		&& lookUp(gl.DeleteBuffers, "glDeleteBuffers")
+		&& lookUp(gl.BindBuffer, "glBindBuffer")
+		&& lookUp(gl.BufferData, "glBufferData")
+		&& lookUp(gl.BufferSubData, "glBufferSubData");
+}
+
+bool loadShaderEntryPoints(){
+	return loadBufferEntryPoints()
+		&& lookUp(gl.CreateShader, "glCreateShader")
+		&& lookUp(gl.DeleteShader, "glDeleteShader")
+		&& lookUp(gl.ShaderSource, "glShaderSource")
+		&& lookUp(gl.CompileShader, "glCompileShader")
+		&& lookUp(gl.GetShaderiv, "glGetShaderiv")
+		&& lookUp(gl.GetShaderInfoLog, "glGetShaderInfoLog")
+		&& lookUp(gl.CreateProgram, "glCreateProgram")
+		&& lookUp(gl.DeleteProgram, "glDeleteProgram")
+		&& lookUp(gl.AttachShader, "glAttachShader")
+		&& lookUp(gl.BindAttribLocation, "glBindAttribLocation")
+		&& lookUp(gl.LinkProgram, "glLinkProgram")
+		&& lookUp(gl.GetProgramiv, "glGetProgramiv")
+		&& lookUp(gl.GetProgramInfoLog, "glGetProgramInfoLog")
+		&& lookUp(gl.UseProgram, "glUseProgram")
+		&& lookUp(gl.VertexAttribPointer, "glVertexAttribPointer")
+		&& lookUp(gl.EnableVertexAttribArray, "glEnableVertexAttribArray")
+		&& lookUp(gl.DisableVertexAttribArray, "glDisableVertexAttribArray")
+		&& lookUp(gl.VertexAttribDivisor, "glVertexAttribDivisor", "glVertexAttribDivisorARB")
+		&& lookUp(gl.DrawArraysInstanced, "glDrawArraysInstanced", "glDrawArraysInstancedARB");
+}
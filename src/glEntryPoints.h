@@ -0,0 +1,70 @@
+//********************************************************
+// OpenGL past 1.1, looked up at run time.
+//
+// Everything the viewer uses beyond GL 1.1 (buffer objects,
+// shaders, instancing) is reached through the 'gl' table
+// below rather than gl.h, so it builds against any gl.h and
+// can check what the context really has before using it.
+// Include it after arGlut.h, for the GL types.
+//********************************************************
+
+#ifndef GLENTRYPOINTS_H
+#define GLENTRYPOINTS_H
+
+#include <stddef.h>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#define HK_ARRAY_BUFFER 0x8892
+#define HK_STATIC_DRAW 0x88E4
+#define HK_DYNAMIC_DRAW 0x88E8
+#define HK_FRAGMENT_SHADER 0x8B30
+#define HK_VERTEX_SHADER 0x8B31
+#define HK_COMPILE_STATUS 0x8B81
+#define HK_LINK_STATUS 0x8B82
+#define HK_ELEMENT_ARRAY_BUFFER 0x8893
+
+typedef ptrdiff_t hkGLsizeiptr;
+typedef ptrdiff_t hkGLintptr;
+
+struct glEntryPoints {
+	void (APIENTRY *GenBuffers)(GLsizei, GLuint*);
+	void (APIENTRY *DeleteBuffers)(GLsizei, const GLuint*);
+	void (APIENTRY *BindBuffer)(GLenum, GLuint);
+	void (APIENTRY *BufferData)(GLenum, hkGLsizeiptr, const void*, GLenum);
+	void (APIENTRY *BufferSubData)(GLenum, hkGLintptr, hkGLsizeiptr, const void*);
+	GLuint (APIENTRY *CreateShader)(GLenum);
+	void (APIENTRY *DeleteShader)(GLuint);
+	void (APIENTRY *ShaderSource)(GLuint, GLsizei, const char* const*, const GLint*);
+	void (APIENTRY *CompileShader)(GLuint);
+	void (APIENTRY *GetShaderiv)(GLuint, GLenum, GLint*);
+	void (APIENTRY *GetShaderInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+	GLuint (APIENTRY *CreateProgram)();
+	void (APIENTRY *DeleteProgram)(GLuint);
+	void (APIENTRY *AttachShader)(GLuint, GLuint);
+	void (APIENTRY *BindAttribLocation)(GLuint, GLuint, const char*);
+	void (APIENTRY *LinkProgram)(GLuint);
+	void (APIENTRY *GetProgramiv)(GLuint, GLenum, GLint*);
+	void (APIENTRY *GetProgramInfoLog)(GLuint, GLsizei, GLsizei*, char*);
+	void (APIENTRY *UseProgram)(GLuint);
+	void (APIENTRY *VertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+	void (APIENTRY *EnableVertexAttribArray)(GLuint);
+	void (APIENTRY *DisableVertexAttribArray)(GLuint);
+	void (APIENTRY *VertexAttribDivisor)(GLuint, GLuint);
+	void (APIENTRY *DrawArraysInstanced)(GLenum, GLint, GLsizei, GLsizei);
+};
+
+extern glEntryPoints gl;
+
+// identifies the current context, for keeping per context GL objects apart.  0 if there isn't one.
+const void* currentContext();
+// whether the current context is at least this GL version
+bool contextHasVersion(int major, int minor);
+// looks up the buffer object functions (GL 1.5).  False if any are missing.
+bool loadBufferEntryPoints();
+// looks up the shader and instanced drawing functions too
+bool loadShaderEntryPoints();
+
+#endif
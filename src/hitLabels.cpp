@@ -0,0 +1,232 @@
+//********************************************************
+// PMT number labels.  See hitLabels.h.
+//********************************************************
+
+#include "arPrecompiled.h"
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+#include "arGlut.h"
+#include "glEntryPoints.h"
+#include "hitLabels.h"
+
+using namespace std;
+
+// the characters a PMT number prints with
+static const char labelCharacters[] = "0123456789-";
+static const int numLabelCharacters = sizeof(labelCharacters) - 1;
+
+// a stroke font character as line segments, in the font's units
+struct strokeGlyph {
+	vector<float> lines;  //x y for each end of each segment
+	float advance;        //how far the next character starts along x
+};
+static strokeGlyph glyphs[numLabelCharacters];
+static bool glyphsReady = false;
+
+// labels were always drawn at a thousandth of the font size
+static const float labelScale = .001f;
+
+// the feedback viewport turns font units in to window coordinates 1:1, give or take this scale and an offset of 1
+static const float captureScale = 256;
+
+static int glyphIndex(char c){
+	if(c >= '0' && c <= '9'){
+		return c - '0';
+	}
+	return c == '-' ? 10 : -1;
+}
+
+/* Draws one character in feedback mode and keeps the line segments GL hands back.  With identity projection, the
+modelview scaled down by captureScale and a 2x2 viewport at the origin, a font point (x, y) comes back as
+(x / captureScale + 1, y / captureScale + 1).  The font moves the modelview on by the character's width when it's
+done, which gives the advance. */
+static bool captureGlyph(char c, strokeGlyph& glyph){
+	const GLint bufferSize = 1 << 14;
+	vector<GLfloat> buffer(bufferSize);
+	glFeedbackBuffer(bufferSize, GL_2D, &buffer[0]);
+	glRenderMode(GL_FEEDBACK);
+	glLoadIdentity();
+	glScalef(1 / captureScale, 1 / captureScale, 1 / captureScale);
+	glutStrokeCharacter(GLUT_STROKE_ROMAN, c);
+	GLfloat moved[16];
+	glGetFloatv(GL_MODELVIEW_MATRIX, moved);
+	GLint size = glRenderMode(GL_RENDER);
+	if(size < 0){
+		return false;  //overflowed
+	}
+	glyph.lines.clear();
+	glyph.advance = moved[12] * captureScale;
+	for(GLint i = 0; i < size; ){
+		GLint token = (GLint)buffer[i++];
+		switch(token){
+		case GL_LINE_TOKEN:
+		case GL_LINE_RESET_TOKEN:
+			for(int k = 0; k < 4; k++){
+				glyph.lines.push_back((buffer[i + k] - 1) * captureScale);
+			}
+			i += 4;
+			break;
+		case GL_POLYGON_TOKEN:
+			i += 1 + 2 * (GLint)buffer[i];
+			break;
+		case GL_POINT_TOKEN:
+		case GL_BITMAP_TOKEN:
+		case GL_DRAW_PIXEL_TOKEN:
+		case GL_COPY_PIXEL_TOKEN:
+			i += 2;
+			break;
+		case GL_PASS_THROUGH_TOKEN:
+			i += 1;
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+bool hitLabels::init(string& error){
+	if(glyphsReady){
+		return true;
+	}
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glViewport(0, 0, 2, 2);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	bool ok = true;
+	for(int k = 0; ok && k < numLabelCharacters; k++){
+		ok = captureGlyph(labelCharacters[k], glyphs[k]);
+	}
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+	if(!ok){
+		error = "hit labels: couldn't capture the stroke font";
+		return false;
+	}
+	glyphsReady = true;
+	return true;
+}
+
+hitLabels::hitLabels() : placement(0), batchVersion(1) {
+}
+
+void hitLabels::build(const hitColumnsView& hits, const hitTransforms& transforms){
+	size_t n = hits.count;
+	placement = &transforms;
+	text.clear();
+	textStart.resize(n + 1);
+	for(size_t i = 0; i < n; i++){
+		char number[16];
+		int length = sprintf(number, "%d", (int)hits.number[i]);
+		textStart[i] = text.size();
+		text.insert(text.end(), number, number + length);
+	}
+	textStart[n] = text.size();
+	visible.clear();
+	batch.clear();
+	batchVersion++;
+}
+
+void hitLabels::update(const hitPicker& picker, const float* points, int numPoints, float range, double until){
+	if(!glyphsReady || !placement){
+		return;
+	}
+	//which hits are close enough to read, each once and in order so the set can be compared with the last
+	nearby.clear();
+	for(int k = 0; k < numPoints; k++){
+		picker.within(&points[3*k], range, until, nearby);
+	}
+	sort(nearby.begin(), nearby.end());
+	nearby.erase(unique(nearby.begin(), nearby.end()), nearby.end());
+	if(nearby == visible){
+		return;
+	}
+
+	//lay the lines out again
+	visible.swap(nearby);
+	batch.clear();
+	for(size_t v = 0; v < visible.size(); v++){
+		unsigned i = visible[v];
+		const float* m = placement->matrix(i);
+		float pen = 0;
+		for(size_t c = textStart[i]; c < textStart[i + 1]; c++){
+			int g = glyphIndex(text[c]);
+			if(g < 0){
+				continue;
+			}
+			const vector<float>& lines = glyphs[g].lines;
+			for(size_t p = 0; p < lines.size(); p += 2){
+				float lx = (pen + lines[p]) * labelScale;
+				float ly = lines[p + 1] * labelScale;
+				batch.push_back(m[0]*lx + m[4]*ly + m[12]);
+				batch.push_back(m[1]*lx + m[5]*ly + m[13]);
+				batch.push_back(m[2]*lx + m[6]*ly + m[14]);
+			}
+			pen += glyphs[g].advance;
+		}
+	}
+	batchVersion++;
+}
+
+labelRenderer::labelRenderer() : buffer(0), inBuffer(false), tried(false), capacity(0), count(0), uploaded(0) {
+}
+
+void labelRenderer::release(){
+	if(inBuffer){
+		gl.DeleteBuffers(1, &buffer);
+	}
+	buffer = 0;
+	inBuffer = tried = false;
+	capacity = count = 0;
+	uploaded = 0;
+}
+
+void labelRenderer::draw(const hitLabels& labels){
+	const vector<float>& lines = labels.lines();
+	if(!tried){
+		tried = true;
+		if(contextHasVersion(1, 5) && loadBufferEntryPoints()){
+			gl.GenBuffers(1, &buffer);
+			inBuffer = true;
+		}
+	}
+	//the buffer only grows, so a new batch that fits is written over the old one
+	if(inBuffer && uploaded != labels.version()){
+		gl.BindBuffer(HK_ARRAY_BUFFER, buffer);
+		if(lines.size() > capacity){
+			capacity = lines.size();
+			gl.BufferData(HK_ARRAY_BUFFER, capacity * sizeof(float), &lines[0], HK_DYNAMIC_DRAW);
+		}
+		else if(!lines.empty()){
+			gl.BufferSubData(HK_ARRAY_BUFFER, 0, lines.size() * sizeof(float), &lines[0]);
+		}
+		gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+		count = lines.size();
+		uploaded = labels.version();
+	}
+	if(lines.empty()){
+		return;
+	}
+	glColor3f(1,1,1);
+	glLineWidth(4);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	if(inBuffer){
+		gl.BindBuffer(HK_ARRAY_BUFFER, buffer);
+		glVertexPointer(3, GL_FLOAT, 0, 0);
+		glDrawArrays(GL_LINES, 0, (GLsizei)(count / 3));
+		gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+	}
+	else{
+		glVertexPointer(3, GL_FLOAT, 0, &lines[0]);
+		glDrawArrays(GL_LINES, 0, (GLsizei)(lines.size() / 3));
+	}
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
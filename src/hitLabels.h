@@ -0,0 +1,70 @@
+//********************************************************
+// PMT number labels for the hits.
+//
+// The digits of the GLUT stroke font are captured once, as
+// line segments, and each event's label text is laid out
+// once when its hit transforms change.  Once a frame the
+// hits within a set distance of the viewer or the wand are
+// looked up in the event's hitPicker grid, so only the cells
+// round those points are looked at, and their labels are laid
+// out as one batch of lines, only when that set of hits has
+// changed.  Each GL context keeps the batch in a buffer of its
+// own (a labelRenderer), uploaded when it changes, so every
+// eye and window just draws it.
+//********************************************************
+
+#ifndef HITLABELS_H
+#define HITLABELS_H
+
+#include <string>
+#include <vector>
+#include "eventData.h"
+#include "hitPrep.h"
+#include "hitPicker.h"
+
+class hitLabels {
+public:
+	hitLabels();
+	// captures the digit glyphs from the stroke font.  Needs a current GL context; once per process is enough.
+	static bool init(std::string& error);
+
+	// lays out the label of every hit.  'transforms' places them and is used until the next build, so rebuild
+	// whenever it's recomputed.
+	void build(const hitColumnsView& hits, const hitTransforms& transforms);
+	// keeps the labels of the hits 'picker' finds within 'range' of any of 'points' (x y z each, in the hits' frame).
+	// 'picker' has to be built from the same transforms.  Only hits with times up to 'until' are labelled, so
+	// playback doesn't label hits it hasn't shown yet.  Once a frame is enough.
+	void update(const hitPicker& picker, const float* points, int numPoints, float range, double until);
+	// the labels' line vertices, x y z each, and a count that goes up whenever they change
+	const std::vector<float>& lines() const { return batch; }
+	unsigned version() const { return batchVersion; }
+	// labels in the batch
+	size_t shown() const { return visible.size(); }
+private:
+	const hitTransforms* placement;
+	std::vector<char> text;              //every hit's PMT number, hit i's being text[textStart[i]] to text[textStart[i+1]]
+	std::vector<size_t> textStart;
+	std::vector<unsigned> visible;       //hits in the batch
+	std::vector<unsigned> nearby;        //scratch for this frame's hits in range
+	std::vector<float> batch;            //line vertices of the visible hits' labels, x y z each
+	unsigned batchVersion;
+};
+
+// One set of labels' lines in one GL context, in a buffer object if the context has them.
+class labelRenderer {
+public:
+	labelRenderer();
+	// frees the buffer.  Needs the context it was drawn in to be current.
+	void release();
+	// draws the labels' lines in white, uploading them first if they've changed since the last draw
+	void draw(const hitLabels& labels);
+private:
+	unsigned buffer;
+	bool inBuffer;
+	bool tried;          //whether the context's been checked for buffer objects
+	size_t capacity;     //floats the buffer has room for
+	size_t count;        //floats in it
+	unsigned uploaded;   //the labels' version as of the last upload
+};
+
+#endif
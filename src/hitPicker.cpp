@@ -0,0 +1,236 @@
+//********************************************************
+// Wand picking.  See hitPicker.h.
+//********************************************************
+
+#include <algorithm>
+#include "hitPicker.h"
+
+using namespace std;
+
+static const int maxCellsAlong = 128;  //cells along each side of the grid, at most (so a cell number fits a byte)
+
+hitPicker::hitPicker() : cellSize(1){
+	for(int k = 0; k < 3; k++){
+		origin[k] = 0;
+		dims[k] = 1;
+	}
+	cellStart.assign(2, 0);
+}
+
+int hitPicker::cellAt(float v, int axis) const {
+	float c = floor((v - origin[axis]) / cellSize);
+	return c >= dims[axis] ? dims[axis] - 1 : (c > 0 ? (int)c : 0);  //NaN goes in the first cell
+}
+
+/* Cells are made about four times the spacing the hits would have spread evenly over the walls of the box, and never
+smaller than a disk, so a cell holds a few disks and a disk reaches in to a few cells. */
+void hitPicker::build(const hitTransforms& transforms, const float* time){
+	size_t n = transforms.size();
+	balls.resize(4 * n);
+	times.resize(n);
+	float low[3] = {0, 0, 0}, high[3] = {0, 0, 0};
+	float largest = 0;
+	for(size_t i = 0; i < n; i++){
+		const float* m = transforms.matrix(i);
+		float r = transforms.radius[i];
+		for(int k = 0; k < 3; k++){
+			balls[4 * i + k] = m[12 + k];
+			low[k] = i == 0 || m[12 + k] - r < low[k] ? m[12 + k] - r : low[k];
+			high[k] = i == 0 || m[12 + k] + r > high[k] ? m[12 + k] + r : high[k];
+		}
+		balls[4 * i + 3] = r;
+		largest = max(largest, r);
+		times[i] = isnan(time[i]) ? HUGE_VALF : time[i];
+	}
+	float size[3], widest = 0;
+	for(int k = 0; k < 3; k++){
+		origin[k] = low[k];
+		size[k] = high[k] - low[k];
+		widest = max(widest, size[k]);
+	}
+	float area = 2 * (size[0] * size[1] + size[1] * size[2] + size[2] * size[0]);
+	cellSize = max(max(4 * sqrt(area / max<size_t>(n, 1)), 2 * largest), widest / maxCellsAlong);
+	if(!(cellSize > 0)){
+		cellSize = 1;
+	}
+	for(int k = 0; k < 3; k++){
+		dims[k] = min(max((int)ceil(size[k] / cellSize), 1), maxCellsAlong);
+	}
+	//the cells each ball reaches, worked out once for both passes.  Nothing's below the origin, so truncating is floor.
+	reach.resize(6 * n);
+	float scale = 1 / cellSize;
+	for(size_t i = 0; i < n; i++){
+		const float* b = &balls[4 * i];
+		for(int k = 0; k < 3; k++){
+			float low = (b[k] - b[3] - origin[k]) * scale, high = (b[k] + b[3] - origin[k]) * scale;
+			reach[6 * i + k] = (unsigned char)(low > 0 ? min((int)low, dims[k] - 1) : 0);
+			reach[6 * i + 3 + k] = (unsigned char)(high > 0 ? min((int)high, dims[k] - 1) : 0);
+		}
+	}
+	//count each disk in to every cell its ball reaches, then list them
+	cellStart.assign((size_t)dims[0] * dims[1] * dims[2] + 1, 0);
+	for(int pass = 0; pass < 2; pass++){
+		for(size_t i = 0; i < n; i++){
+			const unsigned char* r = &reach[6 * i];
+			for(int z = r[2]; z <= r[5]; z++){
+				for(int y = r[1]; y <= r[4]; y++){
+					for(int x = r[0]; x <= r[3]; x++){
+						if(pass == 0){
+							cellStart[cellOf(x, y, z) + 1]++;
+						}
+						else{
+							entries[cellStart[cellOf(x, y, z)]++] = (unsigned)i;
+						}
+					}
+				}
+			}
+		}
+		if(pass == 0){
+			for(size_t c = 1; c < cellStart.size(); c++){
+				cellStart[c] += cellStart[c - 1];
+			}
+			entries.resize(cellStart.back());
+		}
+	}
+	//the fill moved each cell's start up to the next one's
+	for(size_t c = cellStart.size() - 1; c > 0; c--){
+		cellStart[c] = cellStart[c - 1];
+	}
+	cellStart[0] = 0;
+}
+
+bool hitPicker::nearest(const float* point, float range, double until, size_t& hit, float& distance) const {
+	if(balls.empty()){
+		return false;
+	}
+	int from[3], to[3];
+	for(int k = 0; k < 3; k++){
+		from[k] = cellAt(point[k] - range, k);
+		to[k] = cellAt(point[k] + range, k);
+	}
+	float best = range * range;
+	bool found = false;
+	for(int z = from[2]; z <= to[2]; z++){
+		for(int y = from[1]; y <= to[1]; y++){
+			for(int x = from[0]; x <= to[0]; x++){
+				size_t c = cellOf(x, y, z);
+				for(unsigned e = cellStart[c]; e < cellStart[c + 1]; e++){
+					unsigned i = entries[e];
+					if(times[i] > until){
+						continue;
+					}
+					const float* b = &balls[4 * i];
+					float dx = b[0] - point[0], dy = b[1] - point[1], dz = b[2] - point[2];
+					float d = dx*dx + dy*dy + dz*dz;
+					if(d <= best){
+						best = d;
+						hit = i;
+						found = true;
+					}
+				}
+			}
+		}
+	}
+	distance = sqrt(best);
+	return found;
+}
+
+void hitPicker::within(const float* point, float range, double until, vector<unsigned>& hits) const {
+	if(balls.empty()){
+		return;
+	}
+	int from[3], to[3];
+	for(int k = 0; k < 3; k++){
+		from[k] = cellAt(point[k] - range, k);
+		to[k] = cellAt(point[k] + range, k);
+	}
+	float range2 = range * range;
+	for(int z = from[2]; z <= to[2]; z++){
+		for(int y = from[1]; y <= to[1]; y++){
+			for(int x = from[0]; x <= to[0]; x++){
+				size_t c = cellOf(x, y, z);
+				for(unsigned e = cellStart[c]; e < cellStart[c + 1]; e++){
+					unsigned i = entries[e];
+					const float* b = &balls[4 * i];
+					float dx = b[0] - point[0], dy = b[1] - point[1], dz = b[2] - point[2];
+					if(times[i] <= until && dx*dx + dy*dy + dz*dz < range2){
+						hits.push_back(i);
+					}
+				}
+			}
+		}
+	}
+}
+
+/* The ray is clipped to the grid's box, then the cells it crosses are walked in order (Amanatides and Woo): 'next'
+holds how far along the ray it crosses in to the next cell on each axis.  A disk listed in a cell can be reached
+past the cell's far side, so the walk only stops once the nearest disk found is no further than that side. */
+bool hitPicker::alongRay(const float* from, const float* direction, float range, double until, size_t& hit, float& distance) const {
+	float length = sqrt(direction[0]*direction[0] + direction[1]*direction[1] + direction[2]*direction[2]);
+	if(balls.empty() || !(length > 0)){
+		return false;
+	}
+	float d[3];
+	float enter = 0, leave = range;
+	for(int k = 0; k < 3; k++){
+		d[k] = direction[k] / length;
+		float low = origin[k], high = origin[k] + dims[k] * cellSize;
+		if(d[k] == 0){
+			if(from[k] < low || from[k] > high){
+				return false;
+			}
+			continue;
+		}
+		float a = (low - from[k]) / d[k], b = (high - from[k]) / d[k];
+		enter = max(enter, min(a, b));
+		leave = min(leave, max(a, b));
+	}
+	if(enter > leave){
+		return false;
+	}
+	int cell[3], step[3];
+	float next[3], delta[3];
+	for(int k = 0; k < 3; k++){
+		cell[k] = cellAt(from[k] + enter * d[k], k);
+		step[k] = d[k] > 0 ? 1 : -1;
+		delta[k] = d[k] != 0 ? cellSize / fabs(d[k]) : HUGE_VALF;
+		float side = origin[k] + (cell[k] + (d[k] > 0 ? 1 : 0)) * cellSize;
+		next[k] = d[k] != 0 ? (side - from[k]) / d[k] : HUGE_VALF;
+	}
+	float best = range;
+	bool found = false;
+	while(true){
+		size_t c = cellOf(cell[0], cell[1], cell[2]);
+		for(unsigned e = cellStart[c]; e < cellStart[c + 1]; e++){
+			unsigned i = entries[e];
+			if(times[i] > until){
+				continue;
+			}
+			const float* b = &balls[4 * i];
+			float to[3] = {b[0] - from[0], b[1] - from[1], b[2] - from[2]};
+			float along = to[0]*d[0] + to[1]*d[1] + to[2]*d[2];
+			float across = to[0]*to[0] + to[1]*to[1] + to[2]*to[2] - along * along;
+			float inside = b[3] * b[3] - across;
+			if(inside < 0 || along + sqrt(inside) < 0){
+				continue;
+			}
+			float t = max(along - sqrt(inside), 0.0f);  //0 if the ray starts inside the ball
+			if(t <= best){
+				best = t;
+				hit = i;
+				found = true;
+			}
+		}
+		int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2) : (next[1] < next[2] ? 1 : 2);
+		if((found && best <= next[axis]) || next[axis] > leave){
+			break;
+		}
+		cell[axis] += step[axis];
+		if(cell[axis] < 0 || cell[axis] >= dims[axis]){
+			break;
+		}
+		next[axis] += delta[axis];
+	}
+	distance = best;
+	return found;
+}
@@ -0,0 +1,50 @@
+//********************************************************
+// Finding single hits for the wand.
+//
+// Each event's disks are put in a uniform grid over the box
+// round them, every cell listing the disks that reach in to
+// it.  The hits all sit on the tank's walls, so the cells are
+// sized from how far apart the hits are there, and most cells
+// off the walls are empty.  A point query only looks in the
+// cells round the point, and a ray walks the cells it passes
+// through front to back, stopping at the first cell with a
+// disk in it, so either costs microseconds however many hits
+// there are.  The labels ask it for every hit near a point
+// the same way.  The grid is built once per event, with the hit
+// transforms.  Nothing in here depends on Syzygy or OpenGL.
+//********************************************************
+
+#ifndef HITPICKER_H
+#define HITPICKER_H
+
+#include <math.h>
+#include <vector>
+#include "hitPrep.h"
+
+class hitPicker {
+public:
+	hitPicker();
+	// grids the disks 'transforms' places, 'time' being the hits' time column
+	void build(const hitTransforms& transforms, const float* time);
+	// the hit whose centre is nearest 'point', if one is within 'range'.  Only hits with times up to 'until' count.
+	bool nearest(const float* point, float range, double until, size_t& hit, float& distance) const;
+	// appends every hit whose centre is within 'range' of 'point' to 'hits'.  A hit can come up more than once, as a
+	// disk is listed in every cell it reaches.  Only hits with times up to 'until' count.
+	void within(const float* point, float range, double until, std::vector<unsigned>& hits) const;
+	// the first disk the ray from 'from' along 'direction' reaches, within 'range' of 'from'.  Disks are taken as
+	// balls of their radius, which is the disk seen from any side.  Only hits with times up to 'until' count.
+	bool alongRay(const float* from, const float* direction, float range, double until, size_t& hit, float& distance) const;
+private:
+	float origin[3];  //low corner of the grid
+	float cellSize;
+	int dims[3];
+	std::vector<unsigned> cellStart;  //cell c's disks are entries[cellStart[c]] up to entries[cellStart[c+1]]
+	std::vector<unsigned> entries;    //hit indices, cell by cell
+	std::vector<float> balls;         //x y z radius of each hit's disk, in the frame the hits are drawn in
+	std::vector<float> times;         //each hit's time, NaN taken as never
+	std::vector<unsigned char> reach; //scratch, the cells each ball reaches: low x y z then high x y z
+	size_t cellOf(int x, int y, int z) const { return ((size_t)z * dims[1] + y) * dims[0] + x; }
+	int cellAt(float v, int axis) const;  //the cell along one axis a coordinate's in, clamped to the grid
+};
+
+#endif
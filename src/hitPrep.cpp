@@ -0,0 +1,413 @@
+//********************************************************
+// Per-hit drawing data.  See hitPrep.h.
+//********************************************************
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "hitPrep.h"
+
+using namespace std;
+
+// The turn dot::draw always gave side PMTs: acos of 0 in degrees with the viewer's PI of 3.14159, a shade over 90.
+// It's the same for every hit, so its sine and cosine are worked out once.
+// (glRotatef itself converts with the real pi.)
+static const double hitTurnRadians = acos(0.0) * 180 / 3.14159 * (3.14159265358979323846 / 180);
+static const float hitTurnCos = (float)cos(hitTurnRadians);
+static const float hitTurnSin = (float)sin(hitTurnRadians);
+
+/* The turn is about the axis cross(-z, direction) = (dy, -dx, 0), so the glRotatef matrix is written out here with
+z = 0.  The maths runs straight down the hit columns with nothing but selects, so it vectorizes; the matrices are
+then filled in with a second, plain pass. */
+void hitTransforms::compute(const hitColumnsView& hits, double baseRadius, bool scaleByCharge, bool timeCompressed){
+	size_t n = hits.count;
+	matrices.resize(16 * n);
+	radius.resize(n);
+	if(n == 0){
+		return;
+	}
+	//unit turn axis (x, y, 0) for each hit, and w = 1 to turn or 0 to leave the disk facing -z
+	axisX.resize(n);
+	axisY.resize(n);
+	turn.resize(n);
+	float* ax = &axisX[0];
+	float* ay = &axisY[0];
+	float* w = &turn[0];
+	for(size_t i = 0; i < n; i++){
+		float dx = hits.dx[i], dy = hits.dy[i], dz = hits.dz[i];
+		float length = sqrtf(dx*dx + dy*dy + dz*dz);
+		float tx = dx / length, ty = dy / length, tz = dz / length;
+		//in case of end caps, don't need any rotation (trying to would break it)
+		bool endCap = !(length > 0) || fabsf(tz) >= .99f;
+		float axisLength = sqrtf(tx*tx + ty*ty);
+		ax[i] = endCap ? 0 : ty / axisLength;
+		ay[i] = endCap ? 0 : -tx / axisLength;
+		w[i] = endCap ? 0 : 1;
+	}
+
+	const float c = hitTurnCos;
+	const float s = hitTurnSin;
+	float* m = &matrices[0];
+	for(size_t i = 0; i < n; i++){
+		float x = ax[i], y = ay[i], k = w[i];
+		float* o = m + 16 * i;
+		o[0] = 1 + k * (x*x*(1-c) + c - 1);
+		o[1] = x*y*(1-c);
+		o[2] = -y*s;
+		o[3] = 0;
+		o[4] = x*y*(1-c);
+		o[5] = 1 + k * (y*y*(1-c) + c - 1);
+		o[6] = x*s;
+		o[7] = 0;
+		o[8] = y*s;
+		o[9] = -x*s;
+		o[10] = 1 + k * (c - 1);
+		o[11] = 0;
+		o[12] = hits.cx[i] / 100;
+		o[13] = hits.cy[i] / 100;
+		o[14] = -hits.cz[i] / 100;
+		o[15] = 1;
+	}
+
+	float base = (float)baseRadius;
+	float scaleMin = timeCompressed ? .25f : .5f;
+	float limit = (float)chargeScaleLimit;
+	float* r = &radius[0];
+	for(size_t i = 0; i < n; i++){
+		float q = hits.charge[i];
+		bool scaled = scaleByCharge && fabsf(q) < limit;
+		r[i] = scaled ? base * (scaleMin / limit * q + scaleMin) : base;
+	}
+}
+
+// the original charge and time steps and their colors
+static const double defaultChargeEdges[] = {0.2, 0.7, 1.3, 2.2, 3.3, 4.7, 6.2, 8.0, 10, 12.2, 14.7, 17.3, 20.2, 23.3, 26.7};
+static const double defaultTimeEdges[] = {893, 909, 925, 941, 957, 973, 989, 1005, 1021, 1037, 1053, 1069, 1085, 1101, 1117};
+static const unsigned char defaultPalette[][3] = {
+	{132, 4, 186}, {74, 12, 178}, {22, 4, 186}, {4, 124, 186}, {4, 175, 186}, {6, 184, 86}, {40, 183, 7}, {115, 114, 0},
+	{193, 193, 6}, {249, 249, 21}, {253, 213, 80}, {249, 191, 1}, {219, 143, 12}, {219, 129, 12}, {219, 102, 12}, {219, 33, 12}
+};
+
+static hkUint32 packColor(unsigned r, unsigned g, unsigned b){
+	return (hkUint32)r | (hkUint32)g << 8 | (hkUint32)b << 16 | 0xff000000;
+}
+
+colorScales::colorScales(){
+	charge.edges.assign(defaultChargeEdges, defaultChargeEdges + sizeof(defaultChargeEdges) / sizeof(double));
+	time.edges.assign(defaultTimeEdges, defaultTimeEdges + sizeof(defaultTimeEdges) / sizeof(double));
+	for(size_t k = 0; k < sizeof(defaultPalette) / sizeof(defaultPalette[0]); k++){
+		palette.push_back(packColor(defaultPalette[k][0], defaultPalette[k][1], defaultPalette[k][2]));
+	}
+}
+
+//reads "auto" or a list of numbers after a charge / time keyword
+static bool readScale(const char* rest, colorScale& scale){
+	while(*rest == ' ' || *rest == '\t'){
+		rest++;
+	}
+	if(strncmp(rest, "auto", 4) == 0){
+		scale.autoRange = true;
+		return true;
+	}
+	scale.autoRange = false;
+	scale.edges.clear();
+	char* end;
+	for(double v = strtod(rest, &end); end != rest; v = strtod(rest, &end)){
+		if(!scale.edges.empty() && v < scale.edges.back()){
+			return false;
+		}
+		scale.edges.push_back(v);
+		rest = end;
+	}
+	return !scale.edges.empty();
+}
+
+bool colorScales::load(const char* path, string& error){
+	FILE* f = fopen(path, "r");
+	if(!f){
+		error = string("unable to open ") + path;
+		return false;
+	}
+	vector<hkUint32> colors;
+	char line[4096];
+	int lineNumber = 0;
+	bool ok = true;
+	while(ok && fgets(line, sizeof(line), f)){
+		lineNumber++;
+		char* comment = strchr(line, '#');
+		if(comment){
+			*comment = 0;
+		}
+		char keyword[16];
+		int used;
+		if(sscanf(line, " %15s%n", keyword, &used) != 1){
+			continue;  //blank
+		}
+		unsigned r, g, b;
+		if(!strcmp(keyword, "charge")){
+			ok = readScale(line + used, charge);
+		}
+		else if(!strcmp(keyword, "time")){
+			ok = readScale(line + used, time);
+		}
+		else if(!strcmp(keyword, "color") && sscanf(line + used, "%u %u %u", &r, &g, &b) == 3 && r < 256 && g < 256 && b < 256){
+			colors.push_back(packColor(r, g, b));
+		}
+		else{
+			ok = false;
+		}
+	}
+	fclose(f);
+	if(!ok){
+		char where[32];
+		sprintf(where, ":%d", lineNumber);
+		error = string(path) + where + ": expected charge, time or color";
+		return false;
+	}
+	if(!colors.empty()){
+		palette = colors;
+	}
+	if(palette.size() > 256){
+		error = string(path) + ": no more than 256 colors";
+		return false;
+	}
+	if(palette.size() < 2 || (!charge.autoRange && charge.edges.size() + 1 != palette.size()) ||
+		(!time.autoRange && time.edges.size() + 1 != palette.size())){
+		error = string(path) + ": each scale needs one edge fewer than there are colors";
+		return false;
+	}
+	return true;
+}
+
+//the value between the lowest and highest, a fraction 'p' of the way through them in order.  Shuffles 'values'.
+static double percentile(vector<float>& values, double p){
+	size_t k = (size_t)(p * (values.size() - 1) + .5);
+	nth_element(values.begin(), values.begin() + k, values.end());
+	return values[k];
+}
+
+/* Every hit's step is a count of the edges it's past rather than a search, so there are no branches and the count
+runs down the column one edge at a time, which vectorizes.  The thresholds have always been doubles, so each edge is
+first turned in to the float bound that gives exactly the same answer for every float: value > edge just when value
+is at least the first float above the edge, and value < edge just when it's under the first float at or above it. */
+static void colorSet(const float* value, size_t n, const vector<double>& edges, bool rising, const vector<hkUint32>& palette,
+	hkUint32* out){
+	vector<float> bounds(edges.size());
+	for(size_t k = 0; k < edges.size(); k++){
+		float bound = (float)edges[k];
+		if(rising ? (double)bound <= edges[k] : (double)bound < edges[k]){
+			bound = nextafterf(bound, HUGE_VALF);
+		}
+		bounds[k] = bound;
+	}
+	//a block of hits at a time, so every edge's pass over it stays in cache
+	const size_t block = 4096;
+	unsigned char step[block];
+	for(size_t first = 0; first < n; first += block){
+		const float* v = value + first;
+		size_t count = min(block, n - first);
+		memset(step, 0, count);
+		for(size_t k = 0; k < bounds.size(); k++){
+			float bound = bounds[k];
+			if(rising){
+				for(size_t i = 0; i < count; i++){
+					step[i] += v[i] >= bound;
+				}
+			}
+			else{
+				for(size_t i = 0; i < count; i++){
+					step[i] += v[i] < bound;
+				}
+			}
+		}
+		for(size_t i = 0; i < count; i++){
+			out[first + i] = palette[step[i]];
+		}
+	}
+}
+
+void hitColors::compute(const hitColumnsView& innerHits, const hitColumnsView& outerHits, const colorScales& scales, bool byCharge){
+	const colorScale& scale = byCharge ? scales.charge : scales.time;
+	const float* innerValues = byCharge ? innerHits.charge : innerHits.time;
+	const float* outerValues = byCharge ? outerHits.charge : outerHits.time;
+	usedEdges = scale.edges;
+	if(scale.autoRange){
+		values.clear();
+		for(size_t i = 0; i < innerHits.count; i++){
+			if(innerValues[i] == innerValues[i]) values.push_back(innerValues[i]);
+		}
+		for(size_t i = 0; i < outerHits.count; i++){
+			if(outerValues[i] == outerValues[i]) values.push_back(outerValues[i]);
+		}
+		//an event with no hits keeps whatever edges the scale had, it has nothing to color anyway
+		if(!values.empty()){
+			double low = percentile(values, .05);
+			double high = percentile(values, .95);
+			size_t numEdges = scales.palette.size() - 1;
+			usedEdges.resize(numEdges);
+			for(size_t k = 0; k < numEdges; k++){
+				usedEdges[k] = numEdges > 1 ? low + (high - low) * k / (numEdges - 1) : low;
+			}
+		}
+	}
+	//a scale that doesn't fit the palette gets cut short rather than run off the end of it
+	if(usedEdges.size() >= scales.palette.size()){
+		usedEdges.resize(scales.palette.size() - 1);
+	}
+	inner.resize(innerHits.count);
+	outer.resize(outerHits.count);
+	if(innerHits.count){
+		colorSet(innerValues, innerHits.count, usedEdges, byCharge, scales.palette, &inner[0]);
+	}
+	if(outerHits.count){
+		colorSet(outerValues, outerHits.count, usedEdges, byCharge, scales.palette, &outer[0]);
+	}
+}
+
+/* The hits are counting sorted in to cells, then each cell's are sorted by time.  Cells hold a few hundred hits at
+most, so those sorts stay in cache, where one sort of the whole event wouldn't. */
+void hitCells::compute(const hitTransforms& transforms, const float* time, int around, int along){
+	size_t n = transforms.size();
+	size_t numCells = (size_t)around * along;
+	cellStart.assign(numCells + 1, 0);
+	bounds.resize(6 * numCells);
+	order.resize(n);
+	times.resize(n);
+	cellOf.resize(n);
+	keyed.resize(n);
+	float zMin = 0, zMax = 0;
+	for(size_t i = 0; i < n; i++){
+		float z = transforms.matrix(i)[14];
+		zMin = i == 0 || z < zMin ? z : zMin;
+		zMax = i == 0 || z > zMax ? z : zMax;
+	}
+	float zScale = zMax > zMin ? along / (zMax - zMin) : 0;
+	const float angleScale = (float)(around / (2 * 3.14159265358979323846));
+	//counting sort in to cells
+	for(size_t i = 0; i < n; i++){
+		const float* m = transforms.matrix(i);
+		int a = (int)((atan2f(m[13], m[12]) + 3.14159265f) * angleScale);
+		int b = (int)((m[14] - zMin) * zScale);
+		a = a < 0 ? 0 : (a >= around ? around - 1 : a);
+		b = b < 0 ? 0 : (b >= along ? along - 1 : b);
+		cellOf[i] = (unsigned)(b * around + a);
+		cellStart[cellOf[i] + 1]++;
+	}
+	for(size_t c = 0; c < numCells; c++){
+		cellStart[c + 1] += cellStart[c];
+	}
+	vector<unsigned> next(cellStart.begin(), cellStart.end() - 1);
+	bool anyTime = false;
+	earliest = latest = 0;
+	for(size_t i = 0; i < n; i++){
+		//a NaN time is never reached, and as a key it would break the sort
+		float t = time[i];
+		if(isnan(t)){
+			t = HUGE_VALF;
+		}
+		else{
+			earliest = !anyTime || t < earliest ? t : earliest;
+			latest = !anyTime || t > latest ? t : latest;
+			anyTime = true;
+		}
+		keyed[next[cellOf[i]]++] = make_pair(t, (unsigned)i);
+	}
+	for(size_t c = 0; c < numCells; c++){
+		sort(keyed.begin() + cellStart[c], keyed.begin() + cellStart[c + 1]);
+	}
+	for(size_t k = 0; k < n; k++){
+		times[k] = keyed[k].first;
+		order[k] = keyed[k].second;
+	}
+	//boxes round each cell's disks; a disk can't reach further than its radius from its centre in any direction
+	for(size_t c = 0; c < numCells; c++){
+		float* box = &bounds[6 * c];
+		for(unsigned k = cellStart[c]; k < cellStart[c + 1]; k++){
+			const float* m = transforms.matrix(order[k]);
+			float r = transforms.radius[order[k]];
+			for(int d = 0; d < 3; d++){
+				float low = m[12 + d] - r, high = m[12 + d] + r;
+				box[d] = k == cellStart[c] || low < box[d] ? low : box[d];
+				box[3 + d] = k == cellStart[c] || high > box[3 + d] ? high : box[3 + d];
+			}
+		}
+	}
+}
+
+/* The planes come straight out of the combined clip matrix: a point is inside when -w <= x, y, z <= w in clip space,
+and each of those six inequalities is a plane in the modelview's frame. */
+void viewFrustum::fromMatrices(const float* projection, const float* modelview){
+	float clip[16];
+	for(int column = 0; column < 4; column++){
+		for(int row = 0; row < 4; row++){
+			float sum = 0;
+			for(int k = 0; k < 4; k++){
+				sum += projection[k * 4 + row] * modelview[column * 4 + k];
+			}
+			clip[column * 4 + row] = sum;
+		}
+	}
+	for(int p = 0; p < 6; p++){
+		int axis = p / 2;
+		float sign = p % 2 ? -1.0f : 1.0f;
+		for(int column = 0; column < 4; column++){
+			planes[p][column] = clip[column * 4 + 3] + sign * clip[column * 4 + axis];
+		}
+	}
+}
+
+bool viewFrustum::sees(const float* box) const {
+	for(int p = 0; p < 6; p++){
+		const float* plane = planes[p];
+		//the box's corner furthest in to the plane's inside
+		float x = plane[0] >= 0 ? box[3] : box[0];
+		float y = plane[1] >= 0 ? box[4] : box[1];
+		float z = plane[2] >= 0 ? box[5] : box[2];
+		if(plane[0]*x + plane[1]*y + plane[2]*z + plane[3] < 0){
+			return false;
+		}
+	}
+	return true;
+}
+
+string cullStats::report() const {
+	char text[160];
+	sprintf(text, "%lu of %lu cells, %lu of %lu hits drawn (%.0f%%)", (unsigned long)cellsDrawn, (unsigned long)cells,
+		(unsigned long)hitsDrawn, (unsigned long)hits, hits ? 100.0 * hitsDrawn / hits : 100.0);
+	return text;
+}
+
+void visibleRuns(const hitCells& cells, const viewFrustum& frustum, vector<hitRun>& runs, cullStats& stats, double until){
+	runs.clear();
+	stats = cullStats();
+	bool everything = until == HUGE_VAL;
+	for(size_t c = 0; c < cells.numCells(); c++){
+		size_t first = cells.cellStart[c], count = cells.cellStart[c + 1] - first;
+		if(count == 0){
+			continue;
+		}
+		stats.cells++;
+		stats.hits += count;
+		if(!frustum.sees(&cells.bounds[6 * c])){
+			continue;
+		}
+		if(!everything){
+			const float* cellTimes = &cells.times[first];
+			count = upper_bound(cellTimes, cellTimes + count, until) - cellTimes;
+			if(count == 0){
+				continue;
+			}
+		}
+		stats.cellsDrawn++;
+		stats.hitsDrawn += count;
+		if(!runs.empty() && runs.back().first + runs.back().count == first){
+			runs.back().count += count;
+		}
+		else{
+			hitRun run = {first, count};
+			runs.push_back(run);
+		}
+	}
+}
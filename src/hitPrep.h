@@ -0,0 +1,118 @@
+//********************************************************
+// Per-hit drawing data worked out once per event.
+//
+// Hits never move, so where each disk goes and how big it
+// is only needs computing when the event or the scaling
+// options change, not every frame.  Nothing in here touches
+// OpenGL; the viewer feeds the results to it.
+//********************************************************
+
+#ifndef HITPREP_H
+#define HITPREP_H
+
+#include <math.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "eventData.h"
+
+// charges at or above this are drawn at full size when scaling by charge
+static const double chargeScaleLimit = 26.7;
+
+class hitTransforms {
+public:
+	/* model matrix for each hit, 16 floats a hit in column major order for glMultMatrixf: translate to the hit
+	(positions are divided by 100, z flipped), then turn the disk from facing -z to face the PMT direction.  End cap
+	PMTs already face along z and get no turn. */
+	std::vector<float> matrices;
+	std::vector<float> radius;  //disk radius for each hit
+	size_t size() const { return radius.size(); }
+	const float* matrix(size_t i) const { return &matrices[16 * i]; }
+	// fills in every hit's matrix and radius.  With scaleByCharge, hits under chargeScaleLimit shrink towards
+	// half of baseRadius (a quarter for time compressed events, where many hits pile up).
+	void compute(const hitColumnsView& hits, double baseRadius, bool scaleByCharge, bool timeCompressed);
+private:
+	std::vector<float> axisX, axisY, turn;  //scratch columns for compute
+};
+
+// Hits are colored in steps: a value's step is how many of its scale's edges it's past, and the step picks a color
+// from the palette.  Charge steps up as it rises past each edge; time steps down from the top, so early hits get the
+// last colors.
+struct colorScale {
+	std::vector<double> edges;  //ascending
+	bool autoRange;             //spread the edges over each event's values instead, from the 5th to the 95th percentile
+	colorScale() : autoRange(false) {}
+};
+
+struct colorScales {
+	colorScale charge, time;
+	std::vector<hkUint32> palette;  //packed RGBA for each step, red in the lowest byte.  One more than there are edges.
+	// the viewer's original scales
+	colorScales();
+	/* reads scales from a text file.  '#' starts a comment, and a line is one of
+		charge <edges, ascending> | charge auto
+		time <edges, ascending> | time auto
+		color <r g b, 0-255>  (once per step, replacing the whole default palette)
+	Anything not given keeps its default. */
+	bool load(const char* path, std::string& error);
+};
+
+/* Hits bucketed by where they sit on the detector, for culling: cells of the unrolled surface, 'around' steps of
+angle round the tank's axis (z) by 'along' steps down it.  End cap hits land in the end rows by their angle.  The
+hits are listed cell by cell, so a run of cells is a run of hits, and every cell has a box round its disks.  Within
+a cell they're listed in time order, so the hits up to a given time are the front of each cell. */
+class hitCells {
+public:
+	std::vector<unsigned> order;      //hit indices, cell by cell
+	std::vector<float> times;         //the time of each hit in 'order', NaN taken as never
+	std::vector<unsigned> cellStart;  //cell c's hits are order[cellStart[c]] up to order[cellStart[c+1]]
+	std::vector<float> bounds;        //min x y z then max x y z for each cell, in the frame the hits are drawn in
+	float earliest, latest;           //range of the hits' (real) times, both 0 with none
+	hitCells() : earliest(0), latest(0) {}
+	size_t numCells() const { return cellStart.empty() ? 0 : cellStart.size() - 1; }
+	// buckets the hits that 'transforms' places, 'time' being the hits' time column
+	void compute(const hitTransforms& transforms, const float* time, int around, int along);
+private:
+	std::vector<unsigned> cellOf;  //scratch, each hit's cell
+	std::vector<std::pair<float, unsigned> > keyed;  //scratch, each hit's time and index, cell by cell
+};
+
+// The six planes of a view frustum, each a x y z w with the inside where ax + by + cz + w >= 0.
+struct viewFrustum {
+	float planes[6][4];
+	// from the projection and modelview matrices (column major, as glGetFloatv gives them)
+	void fromMatrices(const float* projection, const float* modelview);
+	// false only if the box (min x y z, max x y z) is wholly outside one of the planes
+	bool sees(const float* box) const;
+};
+
+// a stretch of hits in hitCells order, order[first] up to order[first + count]
+struct hitRun {
+	size_t first, count;
+};
+
+struct cullStats {
+	size_t cells, cellsDrawn;  //non-empty cells
+	size_t hits, hitsDrawn;
+	cullStats() : cells(0), cellsDrawn(0), hits(0), hitsDrawn(0) {}
+	std::string report() const;
+};
+
+// the runs of hits in cells the frustum can see, with neighbouring visible cells joined in to one run.  Only hits
+// with times up to 'until' are taken, found by a binary search in each cell; the default takes them all.
+void visibleRuns(const hitCells& cells, const viewFrustum& frustum, std::vector<hitRun>& runs, cullStats& stats,
+	double until = HUGE_VAL);
+
+class hitColors {
+public:
+	std::vector<hkUint32> inner, outer;  //packed color for each hit of each set
+	// colors both sets of an event's hits, by charge or by time, in one pass over the columns
+	void compute(const hitColumnsView& innerHits, const hitColumnsView& outerHits, const colorScales& scales, bool byCharge);
+	// the edges the last compute used, after any auto ranging
+	const std::vector<double>& edges() const { return usedEdges; }
+private:
+	std::vector<double> usedEdges;
+	std::vector<float> values;  //scratch for the percentiles
+};
+
+#endif
@@ -0,0 +1,236 @@
+//********************************************************
+// Instanced hit disk renderer.  See hitRenderer.h.
+//********************************************************
+
+#include "arPrecompiled.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "arGlut.h"
+#include "glEntryPoints.h"
+#include "hitRenderer.h"
+
+using namespace std;
+
+// A function pointer can come back even when the context doesn't support it, so check the version or extensions too.
+static bool contextSupportsInstancing(){
+	if(contextHasVersion(3, 3)){
+		return true;
+	}
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	return contextHasVersion(2, 0) && extensions
+		&& strstr(extensions, "GL_ARB_draw_instanced") && strstr(extensions, "GL_ARB_instanced_arrays");
+}
+
+// generic attribute slots
+enum { ATTRIB_CORNER = 0, ATTRIB_MODEL = 1, ATTRIB_RADIUS = 5, ATTRIB_COLOR = 6 };
+
+// Each instance's model matrix comes in as four columns.  Compatibility GLSL, so Syzygy's modelview and
+// projection (set with the fixed function calls, per eye) carry straight through.
+static const char* vertexShader =
+	"#version 120\n"
+	"attribute vec2 corner;\n"
+	"attribute vec4 model0;\n"
+	"attribute vec4 model1;\n"
+	"attribute vec4 model2;\n"
+	"attribute vec4 model3;\n"
+	"attribute float radius;\n"
+	"attribute vec4 color;\n"
+	"varying vec4 diskColor;\n"
+	"void main(){\n"
+	"	mat4 model = mat4(model0, model1, model2, model3);\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * (model * vec4(corner * radius, 0.0, 1.0));\n"
+	"	diskColor = color;\n"
+	"}\n";
+
+static const char* fragmentShader =
+	"#version 120\n"
+	"varying vec4 diskColor;\n"
+	"void main(){\n"
+	"	gl_FragColor = diskColor;\n"
+	"}\n";
+
+static GLuint compileShader(GLenum type, const char* source, string& error){
+	GLuint shader = gl.CreateShader(type);
+	gl.ShaderSource(shader, 1, &source, 0);
+	gl.CompileShader(shader);
+	GLint ok = 0;
+	gl.GetShaderiv(shader, HK_COMPILE_STATUS, &ok);
+	if(!ok){
+		char log[1024];
+		log[0] = 0;
+		gl.GetShaderInfoLog(shader, sizeof(log), 0, log);
+		error = string("hit shader didn't compile: ") + log;
+		gl.DeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+hitRenderer::hitRenderer() : ready(false), program(0), diskBuffer(0), diskVertices(0) {
+	for(int s = 0; s < NUM_HIT_SETS; s++){
+		sets[s].buffer = 0;
+		sets[s].count = 0;
+		sets[s].capacity = 0;
+	}
+}
+
+bool hitRenderer::init(int slices){
+	release();
+	if(!contextSupportsInstancing() || !loadShaderEntryPoints()){
+		lastError = "OpenGL context has no instanced arrays";
+		return false;
+	}
+	GLuint vertex = compileShader(HK_VERTEX_SHADER, vertexShader, lastError);
+	GLuint fragment = vertex ? compileShader(HK_FRAGMENT_SHADER, fragmentShader, lastError) : 0;
+	if(!fragment){
+		if(vertex) gl.DeleteShader(vertex);
+		return false;
+	}
+	program = gl.CreateProgram();
+	gl.AttachShader(program, vertex);
+	gl.AttachShader(program, fragment);
+	gl.BindAttribLocation(program, ATTRIB_CORNER, "corner");
+	gl.BindAttribLocation(program, ATTRIB_MODEL + 0, "model0");
+	gl.BindAttribLocation(program, ATTRIB_MODEL + 1, "model1");
+	gl.BindAttribLocation(program, ATTRIB_MODEL + 2, "model2");
+	gl.BindAttribLocation(program, ATTRIB_MODEL + 3, "model3");
+	gl.BindAttribLocation(program, ATTRIB_RADIUS, "radius");
+	gl.BindAttribLocation(program, ATTRIB_COLOR, "color");
+	gl.LinkProgram(program);
+	gl.DeleteShader(vertex);  //the program keeps them
+	gl.DeleteShader(fragment);
+	GLint ok = 0;
+	gl.GetProgramiv(program, HK_LINK_STATUS, &ok);
+	if(!ok){
+		char log[1024];
+		log[0] = 0;
+		gl.GetProgramInfoLog(program, sizeof(log), 0, log);
+		lastError = string("hit shader didn't link: ") + log;
+		gl.DeleteProgram(program);
+		program = 0;
+		return false;
+	}
+
+	//unit disk as a triangle fan, the same outline gluDisk draws: centre, then round the rim and back to the start
+	vector<float> disk;
+	disk.push_back(0);
+	disk.push_back(0);
+	for(int i = 0; i <= slices; i++){
+		double angle = 2 * 3.14159265358979323846 * (i % slices) / slices;
+		disk.push_back((float)sin(angle));
+		disk.push_back((float)cos(angle));
+	}
+	diskVertices = slices + 2;
+	gl.GenBuffers(1, &diskBuffer);
+	gl.BindBuffer(HK_ARRAY_BUFFER, diskBuffer);
+	gl.BufferData(HK_ARRAY_BUFFER, disk.size() * sizeof(float), &disk[0], HK_STATIC_DRAW);
+	for(int s = 0; s < NUM_HIT_SETS; s++){
+		gl.GenBuffers(1, &sets[s].buffer);
+	}
+	gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+	ready = true;
+	return true;
+}
+
+void hitRenderer::release(){
+	if(!ready){
+		return;
+	}
+	for(int s = 0; s < NUM_HIT_SETS; s++){
+		gl.DeleteBuffers(1, &sets[s].buffer);
+		sets[s].buffer = 0;
+		sets[s].count = 0;
+		sets[s].capacity = 0;
+	}
+	gl.DeleteBuffers(1, &diskBuffer);
+	gl.DeleteProgram(program);
+	diskBuffer = 0;
+	program = 0;
+	ready = false;
+}
+
+// an instance buffer holds [matrices | radii | colors] for 'capacity' hits
+static size_t radiusOffset(size_t capacity){
+	return capacity * 16 * sizeof(float);
+}
+static size_t colorOffset(size_t capacity){
+	return capacity * 17 * sizeof(float);
+}
+
+void hitRenderer::uploadTransforms(int set, const hitTransforms& transforms, const vector<unsigned>& order){
+	if(!ready){
+		return;
+	}
+	hitSet& h = sets[set];
+	h.count = transforms.size();
+	gl.BindBuffer(HK_ARRAY_BUFFER, h.buffer);
+	if(h.count > h.capacity){
+		h.capacity = h.count;
+		gl.BufferData(HK_ARRAY_BUFFER, colorOffset(h.capacity) + h.capacity * sizeof(hkUint32), 0, HK_DYNAMIC_DRAW);
+	}
+	if(h.count > 0){
+		gathered.resize(h.count * 16);
+		for(size_t k = 0; k < h.count; k++){
+			memcpy(&gathered[16 * k], transforms.matrix(order[k]), 16 * sizeof(float));
+		}
+		gl.BufferSubData(HK_ARRAY_BUFFER, 0, h.count * 16 * sizeof(float), &gathered[0]);
+		for(size_t k = 0; k < h.count; k++){
+			gathered[k] = transforms.radius[order[k]];
+		}
+		gl.BufferSubData(HK_ARRAY_BUFFER, radiusOffset(h.capacity), h.count * sizeof(float), &gathered[0]);
+	}
+	gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+}
+
+void hitRenderer::uploadColors(int set, const hkUint32* colors, size_t count, const vector<unsigned>& order){
+	hitSet& h = sets[set];
+	if(!ready || count > h.capacity || count == 0){
+		return;
+	}
+	gatheredColors.resize(count);
+	for(size_t k = 0; k < count; k++){
+		gatheredColors[k] = colors[order[k]];
+	}
+	gl.BindBuffer(HK_ARRAY_BUFFER, h.buffer);
+	gl.BufferSubData(HK_ARRAY_BUFFER, colorOffset(h.capacity), count * sizeof(hkUint32), &gatheredColors[0]);
+	gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+}
+
+void hitRenderer::draw(int set, const vector<hitRun>& runs){
+	hitSet& h = sets[set];
+	if(!ready || h.count == 0 || runs.empty()){
+		return;
+	}
+	gl.UseProgram(program);
+	gl.BindBuffer(HK_ARRAY_BUFFER, diskBuffer);
+	gl.EnableVertexAttribArray(ATTRIB_CORNER);
+	gl.VertexAttribPointer(ATTRIB_CORNER, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+	gl.BindBuffer(HK_ARRAY_BUFFER, h.buffer);
+	for(int a = ATTRIB_MODEL; a <= ATTRIB_COLOR; a++){
+		gl.EnableVertexAttribArray(a);
+		gl.VertexAttribDivisor(a, 1);
+	}
+	//without base instances (GL 4.2), each run starts the instance attributes at its first hit instead
+	for(size_t r = 0; r < runs.size(); r++){
+		size_t first = runs[r].first;
+		for(int c = 0; c < 4; c++){
+			gl.VertexAttribPointer(ATTRIB_MODEL + c, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float), (const void*)((first * 16 + c * 4) * sizeof(float)));
+		}
+		gl.VertexAttribPointer(ATTRIB_RADIUS, 1, GL_FLOAT, GL_FALSE, 0, (const void*)(radiusOffset(h.capacity) + first * sizeof(float)));
+		gl.VertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, (const void*)(colorOffset(h.capacity) + first * sizeof(hkUint32)));
+		gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, diskVertices, (GLsizei)runs[r].count);
+	}
+
+	//put everything back the way the fixed function drawing expects it
+	for(int a = ATTRIB_MODEL; a <= ATTRIB_COLOR; a++){
+		gl.VertexAttribDivisor(a, 0);
+		gl.DisableVertexAttribArray(a);
+	}
+	gl.DisableVertexAttribArray(ATTRIB_CORNER);
+	gl.BindBuffer(HK_ARRAY_BUFFER, 0);
+	gl.UseProgram(0);
+}
@@ -0,0 +1,61 @@
+//********************************************************
+// Instanced hit disk renderer.
+//
+// One disk mesh is uploaded once, and each hit set (ID and
+// OD) gets an instance buffer holding every hit's model
+// matrix, radius and packed color, gathered from the
+// hitTransforms columns in hitCells order.  Drawing a set is
+// then one glDrawArraysInstanced call per run of visible
+// cells, under whatever modelview and projection Syzygy has
+// loaded for the eye being drawn.
+//
+// Needs GLSL 1.20 shaders plus instanced arrays (GL 3.3, or
+// ARB_draw_instanced and ARB_instanced_arrays), which Mesa's
+// software rasterizer has.  init() says whether the context
+// is up to it; if not the viewer draws hits one at a time.
+//********************************************************
+
+#ifndef HITRENDERER_H
+#define HITRENDERER_H
+
+#include <string>
+#include <vector>
+#include "eventData.h"
+#include "hitPrep.h"
+
+class hitRenderer {
+public:
+	enum { INNER_HITS = 0, OUTER_HITS, NUM_HIT_SETS };
+
+	hitRenderer();
+	// compiles the shader and uploads the disk mesh, in the current GL context.  'slices' matches gluDisk's.
+	bool init(int slices);
+	bool isReady() const { return ready; }
+	const std::string& error() const { return lastError; }
+	// frees the GL objects.  Needs the context init() ran in to be current.
+	void release();
+
+	// replaces set 'set' with these hits' transforms, stored in 'order' (a hitCells order).  For a new event, upload
+	// its colors after this.
+	void uploadTransforms(int set, const hitTransforms& transforms, const std::vector<unsigned>& order);
+	// packed RGBA colors, one per hit in the hits' own order, red in the lowest byte.  Stored in 'order' too.
+	void uploadColors(int set, const hkUint32* colors, size_t count, const std::vector<unsigned>& order);
+	// draws these runs of the set's hits, one instanced call a run
+	void draw(int set, const std::vector<hitRun>& runs);
+private:
+	struct hitSet {
+		unsigned buffer;
+		size_t count;
+		size_t capacity;  //hits the buffer has room for
+	};
+	bool ready;
+	std::string lastError;
+	unsigned program;
+	unsigned diskBuffer;
+	int diskVertices;
+	hitSet sets[NUM_HIT_SETS];
+	std::vector<float> gathered;  //scratch for uploads
+	std::vector<hkUint32> gatheredColors;
+};
+
+#endif
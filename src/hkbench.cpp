@@ -0,0 +1,295 @@
+//********************************************************
+// hkbench: times the data pipeline on an event file, with
+// no window, GL or Syzygy, so load and preparation costs can
+// be tracked from release to release.
+//
+//   hkbench temp_hk.txt [-threads <n>] [-timestep <seconds>]
+//
+// The stages are the ones skeleton goes through: load (parse
+// a text file, or map a .hkev one), physics (energy and cone
+// angle of every particle, in one cherenkovBatch), time
+// compression (only with -timestep) and prep (disk
+// transforms, cells, pick grids and colors for every event,
+// as drawn).
+// Prints one JSON object: each stage's seconds and MB/s,
+// events/s and hits/s, then the totals and the peak resident
+// set size.  It also times what holding the current event
+// costs a frame on the file's biggest event, copying it as
+// postExchange once did against handing out a reference to
+// it as it does now.  The batch physics is also checked against the
+// original one particle at a time formulas; if any result is
+// off by more than rounding, hkbench says so and exits 1.
+//********************************************************
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define PSAPI_VERSION 2
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "cherenkov.h"
+#include "eventData.h"
+#include "eventBinary.h"
+#include "eventParser.h"
+#include "hitPrep.h"
+#include "hitPicker.h"
+#include "mappedFile.h"
+
+using namespace std;
+
+// the viewer's defaults
+static const int cellsAround = 32, cellsAlong = 16;
+// frames timed holding the current event each way
+static const int heldFrames = 2000;
+static const bool scaleByCharge = true;
+static const bool colorByCharge = false;
+
+struct stageTime {
+	const char* name;
+	double seconds;
+	hkUint64 bytes;   //input the stage went through, 0 if it doesn't read the file
+	hkUint64 events;
+	hkUint64 hits;
+};
+
+static hkUint64 countHits(const vector<dotVector>& events){
+	hkUint64 hits = 0;
+	for(size_t e = 0; e < events.size(); e++){
+		hits += events[e].innerHits().count + events[e].outerHits().count;
+	}
+	return hits;
+}
+
+static hkUint64 peakResidentKB(){
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))){
+		return 0;
+	}
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	if(getrusage(RUSAGE_SELF, &usage) != 0){
+		return 0;
+	}
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;  //bytes there
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+static string jsonString(const char* s){
+	string r = "\"";
+	for(; *s; s++){
+		if(*s == '"' || *s == '\\'){
+			r += '\\';
+		}
+		r += *s;
+	}
+	return r + "\"";
+}
+
+static double rate(double amount, double seconds){
+	return seconds > 0 ? amount / seconds : 0;
+}
+
+static void printStage(const stageTime& stage, bool last){
+	printf("    {\"name\": \"%s\", \"seconds\": %.6f, \"mb_per_s\": %.2f, \"events_per_s\": %.1f, \"hits_per_s\": %.1f}%s\n",
+		stage.name, stage.seconds, rate(stage.bytes / 1048576.0, stage.seconds), rate((double)stage.events, stage.seconds),
+		rate((double)stage.hits, stage.seconds), last ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2){
+		fprintf(stderr, "usage: %s <event file> [-threads <n>] [-timestep <seconds>]\n", argv[0]);
+		return 1;
+	}
+	const char* filename = argv[1];
+	unsigned threads = 0;
+	double timeStep = 0;
+	for(int i = 2; i < argc - 1; i++){
+		if(!strcmp(argv[i], "-threads")){
+			threads = atoi(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-timestep")){
+			timeStep = atof(argv[i+1]);
+		}
+	}
+
+	vector<stageTime> stages;
+	vector<dotVector> events;
+	string error;
+
+	//load
+	double started = parseClock();
+	mappedFile file;
+	if(!file.open(filename, error)){
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+	mappedEventFile binary;
+	if(isEventBinaryFile(filename)){
+		if(!binary.open(filename, error)){
+			fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+			return 1;
+		}
+		events.resize(binary.numEvents());
+		for(size_t e = 0; e < events.size(); e++){
+			binary.makeEvent(e, events[e]);
+		}
+	}
+	else{
+		parseEvents(file.data(), file.data() + file.size(), events, 0.0, threads);
+	}
+	for(size_t e = 0; e < events.size(); e++){
+		setDefaultDisplay(events[e]);
+	}
+	stageTime load = { "load", parseClock() - started, file.size(), events.size(), countHits(events) };
+	stages.push_back(load);
+	hkUint64 rawEvents = load.events, rawHits = load.hits;
+
+	//physics, over every particle again in one batch, storing over what the loader worked out
+	started = parseClock();
+	vector<double> types, momenta, energies, angles;
+	for(size_t e = 0; e < events.size(); e++){
+		const dotVector& event = events[e];
+		types.insert(types.end(), event.particleType.begin(), event.particleType.end());
+		momenta.insert(momenta.end(), event.momentum.begin(), event.momentum.end());
+	}
+	hkUint64 particles = types.size();
+	energies.resize(types.size());
+	angles.resize(types.size());
+	if(particles){
+		cherenkovBatch(types.size(), &types[0], &momenta[0], &energies[0], &angles[0]);
+	}
+	for(size_t e = 0, k = 0; e < events.size(); e++){
+		dotVector& event = events[e];
+		for(size_t p = 0; p < event.particleType.size(); p++, k++){
+			event.energy[p] = energies[k];
+			event.coneAngle[p] = angles[k];
+		}
+	}
+	stageTime physics = { "physics", parseClock() - started, 0, events.size(), 0 };
+	stages.push_back(physics);
+
+	//the batch against the original formulas, one particle at a time.  NaN angles (a particle over its threshold
+	//that still can't make a cone) have to come out NaN in both.
+	double physicsError = 0;
+	started = parseClock();
+	for(size_t k = 0; k < types.size(); k++){
+		double energy, angle;
+		particlePhysics(types[k], momenta[k], energy, angle);
+		double errors[2] = { fabs(energies[k] - energy) / max(fabs(energy), 1e-300), fabs(angles[k] - angle) / max(fabs(angle), 1.0) };
+		if(isnan(angle) != isnan(angles[k])){
+			errors[1] = 1;
+		}
+		else if(isnan(angle)){
+			errors[1] = 0;
+		}
+		physicsError = max(physicsError, max(errors[0], errors[1]));
+	}
+	double referenceSeconds = parseClock() - started;
+
+	if(timeStep > 0){
+		started = parseClock();
+		compressEvents(events, timeStep, threads);
+		stageTime compress = { "compress", parseClock() - started, 0, rawEvents, rawHits };
+		stages.push_back(compress);
+	}
+
+	//prep, what the viewer works out each time it shows an event
+	started = parseClock();
+	colorScales scales;
+	hitTransforms innerTransforms, outerTransforms;
+	hitCells innerCells, outerCells;
+	hitPicker innerPicker, outerPicker;
+	hitColors colors;
+	for(size_t e = 0; e < events.size(); e++){
+		hitColumnsView inner = events[e].innerHits();
+		hitColumnsView outer = events[e].outerHits();
+		innerTransforms.compute(inner, innerDotRad, scaleByCharge, timeStep > 0);
+		outerTransforms.compute(outer, innerDotRad, scaleByCharge, timeStep > 0);
+		innerCells.compute(innerTransforms, inner.time, cellsAround, cellsAlong);
+		outerCells.compute(outerTransforms, outer.time, cellsAround, cellsAlong);
+		innerPicker.build(innerTransforms, inner.time);
+		outerPicker.build(outerTransforms, outer.time);
+		colors.compute(inner, outer, scales, colorByCharge);
+	}
+	stageTime prep = { "prep", parseClock() - started, 0, events.size(), countHits(events) };
+	stages.push_back(prep);
+
+	//the current event, copied every frame against a reference handed out every frame.  What each frame reads goes
+	//in to a volatile so neither loop can be left out.
+	size_t biggest = 0;
+	for(size_t e = 1; e < events.size(); e++){
+		if(events[e].innerHits().count + events[e].outerHits().count
+			> events[biggest].innerHits().count + events[biggest].outerHits().count){
+			biggest = e;
+		}
+	}
+	hkUint64 heldHits = 0;
+	double copySeconds = 0, handleSeconds = 0;
+	volatile size_t seen = 0;
+	if(!events.empty()){
+		heldHits = events[biggest].innerHits().count + events[biggest].outerHits().count;
+		dotVector copy;
+		started = parseClock();
+		for(int f = 0; f < heldFrames; f++){
+			copy = events[biggest];
+			seen = copy.innerHits().count + copy.particleType.size();
+		}
+		copySeconds = parseClock() - started;
+		const dotVector* handle = 0;
+		started = parseClock();
+		for(int f = 0; f < heldFrames; f++){
+			handle = &events[(biggest + f % 2) % events.size()];
+			seen = handle->innerHits().count + handle->particleType.size();
+		}
+		handleSeconds = parseClock() - started;
+		(void)seen;
+	}
+
+	double total = 0;
+	for(size_t s = 0; s < stages.size(); s++){
+		total += stages[s].seconds;
+	}
+	printf("{\n");
+	printf("  \"file\": %s,\n", jsonString(filename).c_str());
+	printf("  \"bytes\": %llu,\n", (unsigned long long)file.size());
+	printf("  \"events\": %llu,\n", (unsigned long long)rawEvents);
+	printf("  \"particles\": %llu,\n", (unsigned long long)particles);
+	printf("  \"hits\": %llu,\n", (unsigned long long)rawHits);
+	printf("  \"threads\": %u,\n", threads);
+	printf("  \"timestep\": %g,\n", timeStep);
+	printf("  \"stages\": [\n");
+	for(size_t s = 0; s < stages.size(); s++){
+		printStage(stages[s], s + 1 == stages.size());
+	}
+	printf("  ],\n");
+	printf("  \"total_seconds\": %.6f,\n", total);
+	printf("  \"mb_per_s\": %.2f,\n", rate(file.size() / 1048576.0, total));
+	printf("  \"events_per_s\": %.1f,\n", rate((double)rawEvents, total));
+	printf("  \"hits_per_s\": %.1f,\n", rate((double)rawHits, total));
+	printf("  \"peak_rss_kb\": %llu,\n", (unsigned long long)peakResidentKB());
+	printf("  \"physics_reference_seconds\": %.6f,\n", referenceSeconds);
+	printf("  \"physics_max_error\": %.3g,\n", physicsError);
+	printf("  \"held_event_hits\": %llu,\n", (unsigned long long)heldHits);
+	printf("  \"held_copy_ms_per_frame\": %.6f,\n", 1000 * copySeconds / heldFrames);
+	printf("  \"held_handle_ms_per_frame\": %.6f\n", 1000 * handleSeconds / heldFrames);
+	printf("}\n");
+	if(physicsError > 1e-9){
+		fprintf(stderr, "%s: batch physics differs from particlePhysics by %g\n", argv[0], physicsError);
+		return 1;
+	}
+	return 0;
+}
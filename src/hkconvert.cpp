@@ -0,0 +1,33 @@
+//********************************************************
+// hkconvert: converts a text event file to the binary
+// columnar .hkev format read by skeleton.
+//
+//   hkconvert temp_hk.txt temp_hk.hkev
+//********************************************************
+
+#include <stdio.h>
+#include <time.h>
+#include <string>
+#include "eventBinary.h"
+
+int main(int argc, char** argv) {
+	if(argc != 3){
+		fprintf(stderr, "usage: %s <text event file> <output .hkev file>\n", argv[0]);
+		return 1;
+	}
+	clock_t started = clock();
+	std::string error;
+	if(!convertTextToEventBinary(argv[1], argv[2], error)){
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+
+	//read it back, so a bad conversion is caught here instead of on the CAVE
+	mappedEventFile check;
+	if(!check.open(argv[2], error)){
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+	printf("wrote %lu events to %s in %.2f s\n", (unsigned long)check.numEvents(), argv[2], (double)(clock() - started) / CLOCKS_PER_SEC);
+	return 0;
+}
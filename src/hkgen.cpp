@@ -0,0 +1,596 @@
+//********************************************************
+// hkgen: writes a synthetic text event file, for load and
+// render scaling tests without real detector data.
+//
+//   hkgen out.txt [-events <n>] [-hits <n>] [-od <fraction>]
+//         [-particles <code:weight,...>] [-spacing <seconds>]
+//         [-seed <n>] [-threads <n>]
+//
+// Events are written in the ID/OD/TIME/VERTEX/PARTICLE/
+// NEXTEVENT format loadNextEvent() reads.  Each has a vertex
+// inside the tank and one to three particles drawn from the
+// mix; the inner hits are mostly the particles' Cherenkov
+// rings, thrown out from the vertex at the cone angle the
+// viewer works out and landing on the PMT grid that covers
+// the tank detectorMesh draws, with the rest as noise.  -hits
+// is the mean count of hits an event (ID and OD together),
+// -od the share of them that are OD hits, scattered over a
+// slightly larger copy of the tank and facing out.  Every ID
+// hit is on a different PMT, so an event has at most as many
+// as the grid has PMTs, and hkgen warns if -hits asks for
+// more than that.  Event times are exponentially spaced,
+// -spacing seconds apart on average, so small spacings give
+// a supernova-like burst for -timestep to merge.
+//
+// The file depends only on the options: every event gets
+// its own random stream from the seed and its number, so it
+// comes out the same whatever -threads is.  Events are
+// formatted in batches on every core and written in order.
+//********************************************************
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cherenkov.h"
+#include "detectorShape.h"
+#include "eventData.h"
+#include "eventParser.h"
+
+using namespace std;
+
+static const double PI = 3.14159265358979;
+
+// The tank is detectorShape.h's, in feet; the file is in cm
+static const double feetToCm = 100 / 3.28;
+static const double pmtPitch = .7 * 3.28;    //between PMT centres
+static const double outerScale = 17.61 / 17;  //OD surface against the ID one, as the viewer sizes them
+static const double lightSpeed = .2255 * 3.28;  //in water, feet/ns
+
+// splitmix64, so the numbers are the same on every platform
+class random64 {
+public:
+	random64(hkUint64 seed) : state(seed) {}
+	hkUint64 next(){
+		hkUint64 z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+	double uniform(){ return (next() >> 11) * (1.0 / 9007199254740992.0); }  //[0, 1)
+	double uniform(double a, double b){ return a + (b - a) * uniform(); }
+	size_t below(size_t n){ return (size_t)(uniform() * n); }
+	double exponential(double mean){ return -mean * log(1 - uniform()); }
+	double gauss(double sigma){
+		double u = uniform(), v = uniform();
+		return sigma * sqrt(-2 * log(1 - u)) * cos(2 * PI * v);
+	}
+private:
+	hkUint64 state;
+};
+
+/* The PMTs: a grid round the cross section and along the barrel, and a square grid on each end cap.  The section is
+walked clockwise from the left end of the top wall: the top wall, the right upper arc, the right lower arc, the
+bottom wall, then the left lower and upper arcs. */
+class tankShape {
+public:
+	tankShape(){
+		rTop = sqrt(radiusUpper*radiusUpper - tankHeight * tankHeight / 4) - offsetUpper;
+		rBottom = sqrt(radiusLower*radiusLower - tankHeight * tankHeight / 4) - offsetLower;
+		sweepUpper = asin(tankHeight / 2 / radiusUpper);
+		sweepLower = asin(tankHeight / 2 / radiusLower);
+		double lengths[6] = { 2 * rTop, radiusUpper * sweepUpper, radiusLower * sweepLower, 2 * rBottom, radiusLower * sweepLower, radiusUpper * sweepUpper };
+		pieceStart[0] = 0;
+		for(int k = 0; k < 6; k++){
+			pieceStart[k + 1] = pieceStart[k] + lengths[k];
+		}
+		around = (int)(pieceStart[6] / pmtPitch);
+		along = (int)(tankLength / pmtPitch);
+		halfWidth = radiusUpper - offsetUpper;
+		capColumns = (int)(2 * halfWidth / pmtPitch);
+		capRows = (int)(tankHeight / pmtPitch);
+		barrelPMTs = around * along;
+		capPMTs = capColumns * capRows;
+	}
+	int numPMTs() const { return barrelPMTs + 2 * capPMTs; }
+	// how many of them can be hit: the barrel and the cap squares onTank
+	int hittablePMTs() const {
+		int n = 0;
+		for(int k = 0; k < numPMTs(); k++){
+			n += onTank(k) ? 1 : 0;
+		}
+		return n;
+	}
+
+	// PMT n's (0 based) position and the direction it faces, into the tank
+	void pmt(int n, double* p, double* d) const {
+		if(n < barrelPMTs){
+			sectionPoint((n % around + .5) * pieceStart[6] / around, p, d);
+			p[2] = -tankLength / 2 + (n / around + .5) * tankLength / along;
+			d[2] = 0;
+			return;
+		}
+		n -= barrelPMTs;
+		int cap = n / capPMTs;
+		n %= capPMTs;
+		p[0] = -halfWidth + (n % capColumns + .5) * pmtPitch;
+		p[1] = -tankHeight / 2 + (n / capColumns + .5) * pmtPitch;
+		p[2] = cap ? tankLength / 2 : -tankLength / 2;
+		d[0] = d[1] = 0;
+		d[2] = cap ? -1 : 1;
+	}
+
+	// the PMT nearest to a point on the surface.  At the rim of an end cap, where the cap's grid square has its centre
+	// off the tank, that's the end of the barrel instead.
+	int pmtAt(const double* p) const {
+		if(fabs(p[2]) >= tankLength / 2 - 1e-6){
+			int column = clamp((int)((p[0] + halfWidth) / pmtPitch), capColumns);
+			int row = clamp((int)((p[1] + tankHeight / 2) / pmtPitch), capRows);
+			int n = barrelPMTs + (p[2] > 0 ? capPMTs : 0) + row * capColumns + column;
+			if(onTank(n)){
+				return n;
+			}
+		}
+		int k = clamp((int)(sectionPosition(p[0], p[1]) / pieceStart[6] * around), around);
+		int j = clamp((int)((p[2] + tankLength / 2) / tankLength * along), along);
+		return j * around + k;
+	}
+
+	// an end cap PMT whose centre is outside the section is never hit
+	bool onTank(int n) const {
+		if(n < barrelPMTs){
+			return true;
+		}
+		double p[3], d[3];
+		pmt(n, p, d);
+		return insideTank(p[0], p[1], 0);
+	}
+
+	// where the ray from 'from' (inside) along 'd' leaves the tank
+	void exit(const double* from, const double* d, double* p) const {
+		double t = tankExit(from, d);
+		for(int c = 0; c < 3; c++){
+			p[c] = from[c] + t * d[c];
+		}
+		//put it on an end cap if it's that close, so pmtAt goes by the cap
+		if(fabs(p[2]) > tankLength / 2 - 1e-6){
+			p[2] = p[2] > 0 ? tankLength / 2 : -tankLength / 2;
+		}
+	}
+
+private:
+	static int clamp(int v, int n){ return v < 0 ? 0 : v >= n ? n - 1 : v; }
+
+	// point and inward normal at distance 's' round the section
+	void sectionPoint(double s, double* p, double* d) const {
+		int k = 0;
+		while(k < 5 && s >= pieceStart[k + 1]){
+			k++;
+		}
+		double u = s - pieceStart[k];
+		double a, centre, r;
+		switch(k){
+		case 0: p[0] = -rTop + u; p[1] = tankHeight / 2; d[0] = 0; d[1] = -1; return;
+		case 3: p[0] = rBottom - u; p[1] = -tankHeight / 2; d[0] = 0; d[1] = 1; return;
+		case 1: r = radiusUpper; a = sweepUpper - u / r; p[0] = cos(a) * r - offsetUpper; p[1] = sin(a) * r; centre = -offsetUpper; break;
+		case 2: r = radiusLower; a = u / r; p[0] = cos(a) * r - offsetLower; p[1] = -sin(a) * r; centre = -offsetLower; break;
+		case 4: r = radiusLower; a = sweepLower - u / r; p[0] = offsetLower - cos(a) * r; p[1] = -sin(a) * r; centre = offsetLower; break;
+		default: r = radiusUpper; a = u / r; p[0] = offsetUpper - cos(a) * r; p[1] = sin(a) * r; centre = offsetUpper; break;
+		}
+		//an arc faces its centre
+		d[0] = (centre - p[0]) / r;
+		d[1] = -p[1] / r;
+	}
+
+	// distance round the section of a point on its edge (or, near enough, just inside it)
+	double sectionPosition(double x, double y) const {
+		if(y >= tankHeight / 2 - 1e-6){
+			return pieceStart[0] + (x + rTop);
+		}
+		if(y <= -tankHeight / 2 + 1e-6){
+			return pieceStart[3] + (rBottom - x);
+		}
+		if(y >= 0){
+			double a = atan2(y, fabs(x) + offsetUpper);
+			return x >= 0 ? pieceStart[1] + radiusUpper * (sweepUpper - a) : pieceStart[5] + radiusUpper * a;
+		}
+		double a = atan2(-y, fabs(x) + offsetLower);
+		return x >= 0 ? pieceStart[2] + radiusLower * a : pieceStart[4] + radiusLower * (sweepLower - a);
+	}
+
+	double rTop, rBottom, sweepUpper, sweepLower, halfWidth;
+	double pieceStart[7];
+	int around, along, capColumns, capRows, barrelPMTs, capPMTs;
+};
+
+struct particleChoice {
+	int type;
+	double weight;
+};
+
+struct genOptions {
+	hkUint64 events;
+	double hits;
+	double odFraction;
+	double spacing;
+	hkUint64 seed;
+	unsigned threads;
+	vector<particleChoice> particles;
+};
+
+// appends text for one event at a time, with its own number formatting, as printf would be most of the run time
+class textOut {
+public:
+	vector<char> text;
+	void clear(){ text.clear(); }
+	void word(const char* s){ text.insert(text.end(), s, s + strlen(s)); }
+	void integer(long long v){
+		char digits[24];
+		int n = 0;
+		bool negative = v < 0;
+		unsigned long long u = negative ? 0 - (unsigned long long)v : (unsigned long long)v;
+		do{
+			digits[n++] = (char)('0' + u % 10);
+			u /= 10;
+		}while(u);
+		if(negative){
+			text.push_back('-');
+		}
+		while(n){
+			text.push_back(digits[--n]);
+		}
+	}
+	// v to 'decimals' places, as %.Nf would give but for the odd halfway case
+	void fixed(double v, int decimals){
+		static const double scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+		long long scaled = llround(fabs(v) * scales[decimals]);
+		long long unit = (long long)scales[decimals];
+		if(v < 0 && scaled){
+			text.push_back('-');
+		}
+		integer(scaled / unit);
+		if(decimals){
+			text.push_back('.');
+			long long fraction = scaled % unit;
+			for(long long d = unit / 10; d; d /= 10){
+				text.push_back((char)('0' + fraction / d % 10));
+			}
+		}
+	}
+	void space(){ text.push_back(' '); }
+	void line(){ text.push_back('\n'); }
+};
+
+static void randomDirection(random64& r, double* d){
+	double z = r.uniform(-1, 1);
+	double a = r.uniform(0, 2 * PI);
+	double s = sqrt(1 - z*z);
+	d[0] = s * cos(a);
+	d[1] = s * sin(a);
+	d[2] = z;
+}
+
+// 'axis' turned by 'angle' (radians) round a random direction about it
+static void coneDirection(random64& r, const double* axis, double angle, double* d){
+	double helper[3] = { 1, 0, 0 };
+	if(fabs(axis[0]) > .9){
+		helper[0] = 0;
+		helper[1] = 1;
+	}
+	double u[3] = { axis[1]*helper[2] - axis[2]*helper[1], axis[2]*helper[0] - axis[0]*helper[2], axis[0]*helper[1] - axis[1]*helper[0] };
+	double length = sqrt(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]);
+	for(int c = 0; c < 3; c++){
+		u[c] /= length;
+	}
+	double v[3] = { axis[1]*u[2] - axis[2]*u[1], axis[2]*u[0] - axis[0]*u[2], axis[0]*u[1] - axis[1]*u[0] };
+	double phi = r.uniform(0, 2 * PI);
+	double c = cos(angle), s = sin(angle);
+	for(int k = 0; k < 3; k++){
+		d[k] = c * axis[k] + s * (cos(phi) * u[k] + sin(phi) * v[k]);
+	}
+}
+
+struct genHit {
+	int pmt;
+	float charge;
+	float time;
+};
+
+// One thread's scratch: which PMTs an event has already hit, so hits on the same one add up like real data.
+struct eventWriter {
+	const tankShape& tank;
+	const genOptions& options;
+	vector<int> hitIndex;    //for each PMT, index in 'hits' + 1, or 0
+	vector<genHit> hits;
+	size_t hittable;         //the most inner hits an event can have
+	textOut out;
+	eventWriter(const tankShape& t, const genOptions& o) : tank(t), options(o), hitIndex(t.numPMTs(), 0), hittable(t.hittablePMTs()) {}
+
+	void addHit(int pmt, double charge, double time){
+		int& k = hitIndex[pmt];
+		if(k){
+			hits[k - 1].charge += (float)charge;
+			if(time < hits[k - 1].time) hits[k - 1].time = (float)time;
+			return;
+		}
+		genHit hit = { pmt, (float)charge, (float)time };
+		hits.push_back(hit);
+		k = (int)hits.size();
+	}
+
+	void hitLine(const char* detector, int pmt, double scale, double facing){
+		double p[3], d[3];
+		tank.pmt(pmt, p, d);
+		out.word(detector);
+		out.word(" 0 ");
+		out.integer(pmt + 1);
+		for(int c = 0; c < 3; c++){
+			out.space();
+			out.fixed(p[c] * scale * feetToCm, 2);
+		}
+		for(int c = 0; c < 3; c++){
+			out.space();
+			out.fixed(d[c] * facing, 4);
+		}
+	}
+
+	int randomPMT(random64& r){
+		int pmt;
+		do{
+			pmt = (int)r.below(tank.numPMTs());
+		}while(!tank.onTank(pmt));
+		return pmt;
+	}
+
+	// a PMT on the tank not hit yet, the first one from a random place on.  Only called while there's one left.
+	int unhitPMT(random64& r){
+		int pmt = (int)r.below(tank.numPMTs());
+		while(hitIndex[pmt] || !tank.onTank(pmt)){
+			pmt = (pmt + 1) % tank.numPMTs();
+		}
+		return pmt;
+	}
+
+	void write(hkUint64 number, double endTime){
+		random64 r(options.seed * 0x2545F4914F6CDD1DULL + number);
+		hits.clear();
+
+		//vertex
+		double vertex[3];
+		do{
+			vertex[0] = r.uniform(-tankLength / 2, tankLength / 2);
+			vertex[1] = r.uniform(-tankHeight / 2, tankHeight / 2);
+			vertex[2] = r.uniform(-tankLength / 2, tankLength / 2);
+		}while(!insideTank(vertex[0], vertex[1], vertex[2]));
+
+		//particles, and the rings of those over threshold
+		double totalWeight = 0;
+		for(size_t k = 0; k < options.particles.size(); k++){
+			totalWeight += options.particles[k].weight;
+		}
+		int numParticles = 1 + (int)r.below(3);
+		double directions[3][3], momenta[3], angles[3];
+		int types[3];
+		int rings = 0;
+		for(int k = 0; k < numParticles; k++){
+			double pick = r.uniform() * totalWeight;
+			size_t choice = 0;
+			while(choice + 1 < options.particles.size() && pick >= options.particles[choice].weight){
+				pick -= options.particles[choice].weight;
+				choice++;
+			}
+			types[k] = options.particles[choice].type;
+			randomDirection(r, directions[k]);
+			momenta[k] = r.uniform(100, 1500);
+			double energy;
+			particlePhysics(types[k], momenta[k], energy, angles[k]);
+			if(angles[k] > 0){
+				rings++;
+			}
+		}
+
+		//inner hits: rings, with a tenth noise (all noise without a ring).  Draws on a PMT already hit add to it, so
+		//drawing goes on until there are as many PMTs hit as asked for.  Near the grid's size most draws land on a PMT
+		//already hit, so after twice the draws asked for the rest is noise on PMTs not hit yet.
+		size_t total = (size_t)llround(options.hits * r.uniform(.75, 1.25));
+		size_t outer = (size_t)llround(total * options.odFraction);
+		size_t inner = min(total - outer, hittable);
+		for(size_t draws = 0; hits.size() < inner; draws++){
+			if(draws >= 2 * inner){
+				addHit(unhitPMT(r), r.exponential(.7), r.uniform(900, 1300));
+			}
+			else if(rings && r.uniform() < .9){
+				int k;
+				do{
+					k = (int)r.below(numParticles);
+				}while(!(angles[k] > 0));
+				double d[3], p[3];
+				coneDirection(r, directions[k], (angles[k] + r.gauss(2)) * PI / 180, d);
+				tank.exit(vertex, d, p);
+				double distance = sqrt((p[0]-vertex[0])*(p[0]-vertex[0]) + (p[1]-vertex[1])*(p[1]-vertex[1]) + (p[2]-vertex[2])*(p[2]-vertex[2]));
+				addHit(tank.pmtAt(p), r.exponential(3), 1000 + distance / lightSpeed + r.gauss(1.5));
+			}
+			else{
+				addHit(randomPMT(r), r.exponential(.7), r.uniform(900, 1300));
+			}
+		}
+		for(size_t h = 0; h < hits.size(); h++){
+			hitLine("ID", hits[h].pmt, 1, 1);
+			out.space();
+			out.fixed(hits[h].charge, 3);
+			out.space();
+			out.fixed(hits[h].time, 2);
+			out.line();
+			hitIndex[hits[h].pmt] = 0;
+		}
+		for(size_t h = 0; h < outer; h++){
+			hitLine("OD", randomPMT(r), outerScale, -1);
+			out.space();
+			out.fixed(r.exponential(1), 3);
+			out.space();
+			out.fixed(r.uniform(900, 1300), 2);
+			out.line();
+		}
+
+		out.word("TIME ");
+		out.fixed(endTime, 6);
+		out.line();
+		out.word("VERTEX");
+		for(int c = 0; c < 3; c++){
+			out.space();
+			out.fixed(vertex[c] * feetToCm, 2);
+		}
+		out.line();
+		for(int k = 0; k < numParticles; k++){
+			out.word("PARTICLE ");
+			out.integer(types[k]);
+			for(int c = 0; c < 3; c++){
+				out.space();
+				out.fixed(directions[k][c], 4);
+			}
+			out.space();
+			out.fixed(momenta[k], 2);
+			out.space();
+			out.integer(k);
+			out.line();
+		}
+		out.word("NEXTEVENT\n");
+	}
+};
+
+static bool parseParticles(const char* list, vector<particleChoice>& particles){
+	particles.clear();
+	const char* p = list;
+	while(*p){
+		char* end;
+		particleChoice choice;
+		choice.type = (int)strtol(p, &end, 10);
+		if(end == p || *end != ':'){
+			return false;
+		}
+		p = end + 1;
+		choice.weight = strtod(p, &end);
+		if(end == p || choice.weight < 0){
+			return false;
+		}
+		particles.push_back(choice);
+		p = *end == ',' ? end + 1 : end;
+		if(*end && *end != ','){
+			return false;
+		}
+	}
+	return !particles.empty();
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2){
+		fprintf(stderr, "usage: %s <output file> [-events <n>] [-hits <n>] [-od <fraction>] [-particles <code:weight,...>] [-spacing <seconds>] [-seed <n>] [-threads <n>]\n", argv[0]);
+		return 1;
+	}
+	genOptions options;
+	options.events = 1000;
+	options.hits = 3000;
+	options.odFraction = .02;
+	options.spacing = 1;
+	options.seed = 1;
+	options.threads = 0;
+	parseParticles("11:1,-11:1,13:1,-13:1,211:.5,-211:.5", options.particles);
+	for(int i = 2; i < argc - 1; i++){
+		if(!strcmp(argv[i], "-events")){
+			options.events = strtoull(argv[i+1], 0, 10);
+		}
+		if(!strcmp(argv[i], "-hits")){
+			options.hits = atof(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-od")){
+			options.odFraction = atof(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-particles") && !parseParticles(argv[i+1], options.particles)){
+			fprintf(stderr, "%s: -particles wants code:weight pairs, eg 11:3,13:1\n", argv[0]);
+			return 1;
+		}
+		if(!strcmp(argv[i], "-spacing")){
+			options.spacing = atof(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-seed")){
+			options.seed = strtoull(argv[i+1], 0, 10);
+		}
+		if(!strcmp(argv[i], "-threads")){
+			options.threads = atoi(argv[i+1]);
+		}
+	}
+	if(options.odFraction < 0 || options.odFraction > 1 || options.hits < 0){
+		fprintf(stderr, "%s: -od is a fraction from 0 to 1, and -hits can't be negative\n", argv[0]);
+		return 1;
+	}
+	if(options.threads == 0){
+		options.threads = thread::hardware_concurrency();
+	}
+	if(options.threads == 0){
+		options.threads = 1;
+	}
+
+	FILE* f = fopen(argv[1], "wb");
+	if(!f){
+		fprintf(stderr, "%s: can't write %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	double started = parseClock();
+	tankShape tank;
+	int hittable = tank.hittablePMTs();
+	if(options.hits * (1 - options.odFraction) * 1.25 > hittable){
+		fprintf(stderr, "%s: warning: the tank has %d ID PMTs, so events will have at most that many ID hits\n", argv[0], hittable);
+	}
+	vector<eventWriter*> writers;
+	for(unsigned k = 0; k < options.threads; k++){
+		writers.push_back(new eventWriter(tank, options));
+	}
+
+	//a round is a batch of events for each thread; the times are drawn here, in order, as each follows the last
+	const hkUint64 batch = 64;
+	random64 spacing(options.seed);
+	double time = 0;
+	hkUint64 bytes = 0;
+	bool ok = true;
+	vector<double> endTimes;
+	for(hkUint64 first = 0; ok && first < options.events; first += batch * options.threads){
+		hkUint64 count = options.events - first;
+		if(count > batch * options.threads) count = batch * options.threads;
+		endTimes.resize((size_t)count);
+		for(hkUint64 e = 0; e < count; e++){
+			time += spacing.exponential(options.spacing);
+			endTimes[(size_t)e] = time;
+		}
+		vector<thread> workers;
+		for(unsigned k = 0; k < options.threads && k * batch < count; k++){
+			workers.push_back(thread([&, k]{
+				eventWriter& w = *writers[k];
+				w.out.clear();
+				for(hkUint64 e = k * batch; e < count && e < (k + 1) * batch; e++){
+					w.write(first + e, endTimes[(size_t)e]);
+				}
+			}));
+		}
+		for(size_t k = 0; k < workers.size(); k++){
+			workers[k].join();
+			vector<char>& text = writers[k]->out.text;
+			ok = ok && (text.empty() || fwrite(&text[0], 1, text.size(), f) == text.size());
+			bytes += text.size();
+		}
+	}
+	ok = fclose(f) == 0 && ok;
+	for(size_t k = 0; k < writers.size(); k++){
+		delete writers[k];
+	}
+	if(!ok){
+		fprintf(stderr, "%s: error writing %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	double seconds = parseClock() - started;
+	printf("wrote %llu events, %.1f MB to %s in %.2f s (%.1f MB/s)\n", (unsigned long long)options.events, bytes / 1048576.0, argv[1], seconds, seconds > 0 ? bytes / 1048576.0 / seconds : 0);
+	return 0;
+}
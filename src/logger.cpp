@@ -0,0 +1,149 @@
+//********************************************************
+// Background logger.  See logger.h.
+//********************************************************
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "logger.h"
+
+using namespace std;
+
+static const char* levelNames[] = { "error", "warn", "info", "debug", "trace" };
+
+static atomic<int> runLevel(LOG_INFO);
+
+/* A bounded queue any thread can add to without locking, drained by the one writer thread.  Each slot's sequence says
+whose turn it is: a writer may fill slot s % SLOTS when its sequence is s, and marks it s + 1 when done, which is
+what the reader waits for before taking it and handing it back with s + SLOTS. */
+class logQueue {
+public:
+	enum { SLOTS = 1024, LINE = 256 };
+	logQueue() : tail(0), head(0), dropped(0), written(0), stopping(false) {
+		for(size_t s = 0; s < SLOTS; s++){
+			slots[s].sequence.store(s, memory_order_relaxed);
+		}
+		writer = thread(&logQueue::run, this);
+	}
+	~logQueue(){
+		stopping.store(true);
+		writer.join();
+	}
+	void push(int level, const char* format, va_list args){
+		size_t position = tail.load(memory_order_relaxed);
+		slot* s;
+		for(;;){
+			s = &slots[position % SLOTS];
+			size_t sequence = s->sequence.load(memory_order_acquire);
+			if(sequence == position){
+				if(tail.compare_exchange_weak(position, position + 1, memory_order_relaxed)){
+					break;
+				}
+			}
+			else if(sequence < position){
+				dropped.fetch_add(1, memory_order_relaxed);  //full
+				return;
+			}
+			else{
+				position = tail.load(memory_order_relaxed);
+			}
+		}
+		s->level = level;
+		vsnprintf(s->text, LINE, format, args);
+		s->sequence.store(position + 1, memory_order_release);
+	}
+	void flush(){
+		size_t queued = tail.load();
+		while(written.load() < queued){
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	}
+private:
+	struct slot {
+		atomic<size_t> sequence;
+		int level;
+		char text[LINE];
+	};
+	// writes out whatever's ready, returning how many
+	size_t drain(){
+		size_t n = 0;
+		for(;;){
+			slot& s = slots[head % SLOTS];
+			if(s.sequence.load(memory_order_acquire) != head + 1){
+				break;
+			}
+			int level = s.level >= LOG_ERROR && s.level <= LOG_TRACE ? s.level : LOG_TRACE;
+			fprintf(stdout, "[%s] %s\n", levelNames[level], s.text);
+			s.sequence.store(head + SLOTS, memory_order_release);
+			head++;
+			n++;
+		}
+		size_t lost = dropped.exchange(0, memory_order_relaxed);
+		if(lost){
+			fprintf(stdout, "[warn] log queue full, %lu messages dropped\n", (unsigned long)lost);
+		}
+		if(n || lost){
+			fflush(stdout);
+		}
+		written.store(head);
+		return n;
+	}
+	void run(){
+		while(!stopping.load()){
+			if(!drain()){
+				this_thread::sleep_for(chrono::milliseconds(5));
+			}
+		}
+		drain();
+	}
+
+	slot slots[SLOTS];
+	atomic<size_t> tail;  //next position a writer takes
+	size_t head;          //next position the reader takes, only touched by it
+	atomic<size_t> dropped;
+	atomic<size_t> written;
+	atomic<bool> stopping;
+	thread writer;
+};
+
+// started by the first message, and drained and stopped when the program exits
+static logQueue& queue(){
+	static logQueue q;
+	return q;
+}
+
+void logger::setLevel(int level){
+	runLevel.store(level, memory_order_relaxed);
+}
+
+bool logger::wants(int level){
+	return level <= runLevel.load(memory_order_relaxed);
+}
+
+void logger::write(int level, const char* format, ...){
+	va_list args;
+	va_start(args, format);
+	queue().push(level, format, args);
+	va_end(args);
+}
+
+void logger::flush(){
+	queue().flush();
+}
+
+logRateLimit::logRateLimit(double i) : interval((long long)(i * 1e9)), last(0), suppressed(0) {
+}
+
+bool logRateLimit::allow(unsigned& held){
+	long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	long long previous = last.load(memory_order_relaxed);
+	//only one of the threads that find the interval up gets to write
+	if((previous && now - previous < interval) || !last.compare_exchange_strong(previous, now, memory_order_relaxed)){
+		suppressed.fetch_add(1, memory_order_relaxed);
+		return false;
+	}
+	held = suppressed.exchange(0, memory_order_relaxed);
+	return true;
+}
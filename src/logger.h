@@ -0,0 +1,79 @@
+//********************************************************
+// Leveled logging that stays off the render thread.
+//
+// HK_LOG(level, format, ...) formats the message straight in
+// to a slot of a fixed, lock-free queue and returns; one
+// background thread writes the queue out to stdout.  If the
+// queue is ever full the message is dropped and counted rather
+// than making the caller wait.
+//
+// Messages above HK_LOG_LEVEL (LOG_INFO unless the build says
+// otherwise, e.g. make LOGLEVEL=4) are compiled out along with
+// their arguments, and those above the run time level (-loglevel
+// <n>) cost one compare.  HK_LOG_EVERY is for messages that would
+// otherwise come every frame: each call site writes at most one
+// a given number of seconds, saying how many it held back.
+// Nothing in here depends on Syzygy.
+//********************************************************
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+
+enum logLevel {
+	LOG_ERROR = 0,
+	LOG_WARN = 1,
+	LOG_INFO = 2,
+	LOG_DEBUG = 3,
+	LOG_TRACE = 4   //per frame
+};
+
+#ifndef HK_LOG_LEVEL
+#define HK_LOG_LEVEL LOG_INFO
+#endif
+
+class logger {
+public:
+	// messages above this level are skipped.  Starts at LOG_INFO.
+	static void setLevel(int level);
+	static bool wants(int level);
+	// queues a printf style message
+	static void write(int level, const char* format, ...)
+#ifdef __GNUC__
+		__attribute__((format(printf, 2, 3)))
+#endif
+		;
+	// blocks until everything queued so far is written
+	static void flush();
+};
+
+// One call site of HK_LOG_EVERY, letting a message through at most every 'interval' seconds.  Safe to share between
+// the window threads.
+class logRateLimit {
+public:
+	logRateLimit(double interval);
+	// true if the message can go now, with 'held' set to how many were held back since the last one
+	bool allow(unsigned& held);
+private:
+	long long interval;  //ns
+	std::atomic<long long> last;
+	std::atomic<unsigned> suppressed;
+};
+
+#define HK_LOG(level, ...) \
+	do{ if((level) <= HK_LOG_LEVEL && logger::wants(level)) logger::write((level), __VA_ARGS__); }while(0)
+
+#define HK_LOG_EVERY(level, seconds, ...) \
+	do{ \
+		if((level) <= HK_LOG_LEVEL && logger::wants(level)){ \
+			static logRateLimit hkLogLimit(seconds); \
+			unsigned hkLogHeld; \
+			if(hkLogLimit.allow(hkLogHeld)){ \
+				logger::write((level), __VA_ARGS__); \
+				if(hkLogHeld) logger::write((level), "  (and %u more like that)", hkLogHeld); \
+			} \
+		} \
+	}while(0)
+
+#endif
@@ -0,0 +1,92 @@
+//********************************************************
+// Read-only file mapping.  See mappedFile.h.
+//********************************************************
+
+#include "mappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+mappedFile::mappedFile() : base(0), mappedSize(0), opened(false) {
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mappingHandle = 0;
+#endif
+}
+
+mappedFile::~mappedFile(){
+	close();
+}
+
+bool mappedFile::open(const char* path, string& error){
+	close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, 0);
+	if(fileHandle == INVALID_HANDLE_VALUE){
+		error = string("unable to open ") + path;
+		return false;
+	}
+	LARGE_INTEGER size;
+	GetFileSizeEx((HANDLE)fileHandle, &size);
+	mappedSize = (size_t)size.QuadPart;
+	if(mappedSize > 0){
+		mappingHandle = CreateFileMappingA((HANDLE)fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+		if(mappingHandle){
+			base = (const char*)MapViewOfFile((HANDLE)mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+#else
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0){
+		error = string("unable to open ") + path;
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size > 0){
+		mappedSize = (size_t)st.st_size;
+		void* p = mmap(0, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+		if(p != MAP_FAILED){
+			base = (const char*)p;
+		}
+	}
+	::close(fd);  //the mapping keeps the file alive
+#endif
+	if(!base && mappedSize > 0){
+		error = string("unable to map ") + path;
+		close();
+		return false;
+	}
+	opened = true;
+	return true;
+}
+
+void mappedFile::close(){
+#ifdef _WIN32
+	if(base){
+		UnmapViewOfFile(base);
+	}
+	if(mappingHandle){
+		CloseHandle((HANDLE)mappingHandle);
+	}
+	if(fileHandle != INVALID_HANDLE_VALUE){
+		CloseHandle((HANDLE)fileHandle);
+	}
+	mappingHandle = 0;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if(base){
+		munmap((void*)base, mappedSize);
+	}
+#endif
+	base = 0;
+	mappedSize = 0;
+	opened = false;
+}
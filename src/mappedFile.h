@@ -0,0 +1,35 @@
+//********************************************************
+// Read-only memory mapping of a whole file, used for both
+// .hkev files and text event files.  An empty file opens
+// fine and maps to zero bytes.
+//********************************************************
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <stddef.h>
+#include <string>
+
+class mappedFile {
+public:
+	mappedFile();
+	~mappedFile();
+	bool open(const char* path, std::string& error);
+	void close();
+	bool isOpen() const { return opened; }
+	const char* data() const { return base; }
+	size_t size() const { return mappedSize; }
+private:
+	mappedFile(const mappedFile&);
+	mappedFile& operator=(const mappedFile&);
+
+	const char* base;
+	size_t mappedSize;
+	bool opened;
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
+
+#endif
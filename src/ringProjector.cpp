@@ -0,0 +1,220 @@
+//********************************************************
+// Cone rings on the tank wall.  See ringProjector.h.
+//********************************************************
+
+#include <math.h>
+#include <algorithm>
+#include "detectorShape.h"
+#include "ringProjector.h"
+
+using namespace std;
+
+void vertexInHitFrame(const dotVector& event, double* vertex){
+	//the loader's vz is (z * 20/1810 + 20) * 3.28 for z in cm, and hits are drawn at -z
+	double zCm = (event.vertexPosition[2] / 3.28 - 20) * 1810 / 20;
+	vertex[0] = event.vertexPosition[0];
+	vertex[1] = event.vertexPosition[1];
+	vertex[2] = -zCm / 100 * 3.28;
+}
+
+// distance from p to the segment a-b
+static double segmentDistance(const vec3& p, const vec3& a, const vec3& b){
+	double ab[3], ap[3];
+	double dot = 0, length = 0;
+	for(int k = 0; k < 3; k++){
+		ab[k] = b[k] - a[k];
+		ap[k] = p[k] - a[k];
+		dot += ab[k] * ap[k];
+		length += ab[k] * ab[k];
+	}
+	double t = length > 0 ? min(max(dot / length, 0.0), 1.0) : 0;
+	double d = 0;
+	for(int k = 0; k < 3; k++){
+		double e = ap[k] - t * ab[k];
+		d += e * e;
+	}
+	return sqrt(d);
+}
+
+/* Douglas-Peucker: a run of samples is replaced by its end points if none of it is further than the tolerance from
+the line between them, else it's split at the furthest sample and both halves are tried again.  The ring is closed,
+so it starts as three runs rather than one from a point back to itself. */
+static void simplify(const vector<vec3>& samples, vector<vec3>& out){
+	size_t last = samples.size() - 1;
+	vector<bool> keepPoint(samples.size(), false);
+	vector<pair<size_t, size_t> > runs;
+	for(size_t k = 0; k < 3; k++){
+		keepPoint[k * last / 3] = true;
+		runs.push_back(make_pair(k * last / 3, (k + 1) * last / 3));
+	}
+	keepPoint[last] = true;
+	while(!runs.empty()){
+		size_t first = runs.back().first, end = runs.back().second;
+		runs.pop_back();
+		double furthest = 0;
+		size_t split = first;
+		for(size_t i = first + 1; i < end; i++){
+			double d = segmentDistance(samples[i], samples[first], samples[end]);
+			if(d > furthest){
+				furthest = d;
+				split = i;
+			}
+		}
+		if(furthest > ringTolerance){
+			keepPoint[split] = true;
+			runs.push_back(make_pair(first, split));
+			runs.push_back(make_pair(split, end));
+		}
+	}
+	out.clear();
+	for(size_t i = 0; i < samples.size(); i++){
+		if(keepPoint[i]){
+			out.push_back(samples[i]);
+		}
+	}
+}
+
+void projectRing(const double* vertex, const vec3& direction, double coneAngle, vector<vec3>& ring, vector<vec3>& spokes){
+	ring.clear();
+	spokes.clear();
+	//NaN angles (see particlePhysics) fail this too
+	if(!(coneAngle > 0) || !insideTank(vertex[0], vertex[1], vertex[2])){
+		return;
+	}
+	//the axis in the hit frame, and two directions square to it and each other
+	double axis[3] = { direction[0], direction[1], -direction[2] };
+	double length = sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]);
+	if(!(length > 0)){
+		return;
+	}
+	for(int k = 0; k < 3; k++){
+		axis[k] /= length;
+	}
+	double across[3] = { 1, 0, 0 };
+	if(fabs(axis[0]) > .9){
+		across[0] = 0;
+		across[1] = 1;
+	}
+	double u[3] = { axis[1]*across[2] - axis[2]*across[1], axis[2]*across[0] - axis[0]*across[2], axis[0]*across[1] - axis[1]*across[0] };
+	length = sqrt(u[0]*u[0] + u[1]*u[1] + u[2]*u[2]);
+	for(int k = 0; k < 3; k++){
+		u[k] /= length;
+	}
+	double w[3] = { axis[1]*u[2] - axis[2]*u[1], axis[2]*u[0] - axis[0]*u[2], axis[0]*u[1] - axis[1]*u[0] };
+
+	const double PI = 3.14159265358979;
+	double along = cos(coneAngle * PI / 180), out = sin(coneAngle * PI / 180);
+	vector<vec3> samples(ringSamples + 1);
+	for(int i = 0; i < ringSamples; i++){
+		double phi = 2 * PI * i / ringSamples;
+		double c = out * cos(phi), s = out * sin(phi);
+		double d[3];
+		for(int k = 0; k < 3; k++){
+			d[k] = along * axis[k] + c * u[k] + s * w[k];
+		}
+		double t = tankExit(vertex, d);
+		samples[i] = vec3((float)(vertex[0] + t * d[0]), (float)(vertex[1] + t * d[1]), (float)(vertex[2] + t * d[2]));
+	}
+	samples[ringSamples] = samples[0];
+	simplify(samples, ring);
+	for(int i = 0; i < ringSpokes; i++){
+		spokes.push_back(samples[i * ringSamples / ringSpokes]);
+	}
+}
+
+ringWorkers::ringWorkers(unsigned threadCount, size_t keepCount) : stopping(false), current(0), keep(max<size_t>(keepCount, 1)){
+	for(unsigned k = 0; k < max(threadCount, 1u); k++){
+		threads.push_back(thread(&ringWorkers::work, this));
+	}
+}
+
+ringWorkers::~ringWorkers(){
+	{
+		lock_guard<mutex> hold(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for(size_t k = 0; k < threads.size(); k++){
+		threads[k].join();
+	}
+}
+
+void ringWorkers::request(size_t index, const dotVector& event){
+	lock_guard<mutex> hold(lock);
+	if(done.count(index) || queued.count(index)){
+		return;
+	}
+	job j;
+	j.index = index;
+	vertexInHitFrame(event, j.vertex);
+	j.direction = event.coneDirection;
+	j.coneAngle = event.coneAngle;
+	queue.push_back(j);
+	queued.insert(index);
+	wake.notify_one();
+}
+
+void ringWorkers::setCurrent(size_t index){
+	lock_guard<mutex> hold(lock);
+	current = index;
+}
+
+bool ringWorkers::fill(size_t index, dotVector& event){
+	lock_guard<mutex> hold(lock);
+	map<size_t, result>::iterator found = done.find(index);
+	if(found == done.end()){
+		return false;
+	}
+	result& r = found->second;
+	lru.splice(lru.begin(), lru, r.lru);
+	size_t n = min(r.particles.size(), event.ringPoints.size());
+	for(size_t p = 0; p < n; p++){
+		if(event.ringPoints[p].size() < 2){
+			event.ringPoints[p].resize(2);
+		}
+		event.ringPoints[p][0].ringPoints = r.particles[p].ring;
+		event.ringPoints[p][1].ringPoints = r.particles[p].spokes;
+		event.haveRingPoints[p] = true;
+	}
+	return true;
+}
+
+void ringWorkers::work(){
+	unique_lock<mutex> hold(lock);
+	while(true){
+		wake.wait(hold, [this]{ return stopping || !queue.empty(); });
+		if(stopping){
+			return;
+		}
+		//the queued event nearest the current one
+		list<job>::iterator next = queue.begin();
+		size_t nearest = (size_t)-1;
+		for(list<job>::iterator j = queue.begin(); j != queue.end(); ++j){
+			size_t distance = j->index > current ? j->index - current : current - j->index;
+			if(distance < nearest){
+				nearest = distance;
+				next = j;
+			}
+		}
+		job j;
+		swap(j, *next);
+		queue.erase(next);
+
+		hold.unlock();
+		vector<particleRing> rings(j.coneAngle.size());
+		for(size_t p = 0; p < rings.size() && p < j.direction.size(); p++){
+			projectRing(j.vertex, j.direction[p], j.coneAngle[p], rings[p].ring, rings[p].spokes);
+		}
+		hold.lock();
+
+		queued.erase(j.index);
+		result& r = done[j.index];
+		r.particles.swap(rings);
+		lru.push_front(j.index);
+		r.lru = lru.begin();
+		while(done.size() > keep){
+			done.erase(lru.back());
+			lru.pop_back();
+		}
+	}
+}
@@ -0,0 +1,85 @@
+//********************************************************
+// Cherenkov rings on the tank wall, worked out off the
+// render thread.
+//
+// A particle's ring is where its cone (from the event vertex,
+// round the particle's direction, at its cone angle) meets the
+// tank in detectorShape.h.  Rays are thrown round the cone and
+// the points where they leave the tank thinned down to a
+// polyline that stays within ringTolerance of the curve.
+// ringWorkers does this on background threads for the events
+// it's asked for, nearest the current event first, and keeps
+// the rings it's done for the viewer to pick up.  Asking never
+// waits.  Nothing in here depends on Syzygy or OpenGL.
+//********************************************************
+
+#ifndef RINGPROJECTOR_H
+#define RINGPROJECTOR_H
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include "eventData.h"
+
+static const int ringSamples = 256;        //rays thrown round each cone
+static const double ringTolerance = .05 * 3.28;  //feet the polyline can be off the curve
+static const int ringSpokes = 8;           //lines drawn from the vertex out to the ring
+
+// the event's vertex in the frame its hits are drawn in (feet).  The loader stores z the way the outer detector's
+// hits were, so that's undone here.
+void vertexInHitFrame(const dotVector& event, double* vertex);
+
+// one particle's ring, from a vertex in the hit frame and a cone direction in the file's frame (as coneDirection is)
+// with a cone angle in degrees.  'ring' is the closed polyline, its last point the same as its first, and 'spokes'
+// ringSpokes points on it spread round the cone.  Both are left empty if there's no ring to draw: the particle is
+// under threshold or the vertex isn't in the tank.
+void projectRing(const double* vertex, const vec3& direction, double coneAngle, std::vector<vec3>& ring,
+	std::vector<vec3>& spokes);
+
+class ringWorkers {
+public:
+	// 'threads' background threads, keeping the rings of the last 'keep' events done
+	ringWorkers(unsigned threads, size_t keep);
+	~ringWorkers();
+	// queues event 'index' unless its rings are done or queued already.  What's needed is copied, so the event can
+	// be evicted or changed afterwards.
+	void request(size_t index, const dotVector& event);
+	// queued events are done nearest this one first
+	void setCurrent(size_t index);
+	// if event 'index' is done, copies its rings in to the event's ringPoints (ring in [p][0], spokes in [p][1]),
+	// sets haveRingPoints and returns true
+	bool fill(size_t index, dotVector& event);
+private:
+	struct particleRing {
+		std::vector<vec3> ring;
+		std::vector<vec3> spokes;
+	};
+	struct job {
+		size_t index;
+		double vertex[3];
+		std::vector<vec3> direction;
+		std::vector<double> coneAngle;
+	};
+	struct result {
+		std::vector<particleRing> particles;
+		std::list<size_t>::iterator lru;
+	};
+	void work();
+
+	std::mutex lock;
+	std::condition_variable wake;
+	bool stopping;
+	size_t current;
+	size_t keep;
+	std::list<job> queue;
+	std::set<size_t> queued;  //events in 'queue' or being worked on
+	std::map<size_t, result> done;
+	std::list<size_t> lru;  //most recently filled at the front
+	std::vector<std::thread> threads;
+};
+
+#endif
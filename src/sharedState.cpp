@@ -0,0 +1,67 @@
+//********************************************************
+// Master to slave UI state.  See sharedState.h.
+//********************************************************
+
+#include <string.h>
+#include "sharedState.h"
+
+using namespace std;
+
+void recordDisplayChange(displayChannel& channel, size_t event, size_t particle, bool on){
+	channel.latest++;
+	displayChange& change = channel.slots[channel.latest % displayChannel::SLOTS];
+	change.sequence = channel.latest;
+	change.event = (hkUint32)event;
+	change.particle = (hkUint32)particle;
+	change.on = on;
+}
+
+bool newDisplayChanges(const displayChannel& channel, hkUint32& applied, vector<displayChange>& changes){
+	changes.clear();
+	if(channel.latest == applied){
+		return true;
+	}
+	hkUint32 oldest = channel.latest > displayChannel::SLOTS ? channel.latest - displayChannel::SLOTS + 1 : 1;
+	//a slave that's ahead of the master has seen a master restart, so it starts again from what's there
+	bool complete = applied < channel.latest && applied + 1 >= oldest;
+	hkUint32 first = complete ? applied + 1 : oldest;
+	for(hkUint32 s = first; s <= channel.latest; s++){
+		const displayChange& change = channel.slots[s % displayChannel::SLOTS];
+		if(change.sequence == s){
+			changes.push_back(change);
+		}
+	}
+	applied = channel.latest;
+	return complete;
+}
+
+void packShownDisplay(shownDisplay& shown, size_t event, const vector<bool>& display){
+	memset(&shown, 0, sizeof(shown));
+	shown.event = (hkUint32)event;
+	shown.particles = (hkUint32)(display.size() < (size_t)shownDisplay::BITS ? display.size() : (size_t)shownDisplay::BITS);
+	for(size_t p = 0; p < shown.particles; p++){
+		if(display[p]){
+			shown.bits[p / 32] |= 1u << (p % 32);
+		}
+	}
+}
+
+stateSender::stateSender(int r) : sentAny(false), refreshFrames(r), sinceSent(0) {
+	memset(&last, 0, sizeof(last));
+}
+
+bool stateSender::frame(sharedState& next){
+	next.version = sharedStateVersion;
+	next.sequence = last.sequence;
+	bool changed = !sentAny || memcmp(&next, &last, sizeof(next)) != 0;
+	if(changed){
+		next.sequence++;
+	}
+	if(!changed && ++sinceSent < refreshFrames){
+		return false;
+	}
+	last = next;
+	sentAny = true;
+	sinceSent = 0;
+	return true;
+}
@@ -0,0 +1,114 @@
+//********************************************************
+// What the master shares with the slaves every frame.
+//
+// The whole of the master's UI state is one fixed size, plain
+// struct, sent as a single transfer field and only in frames
+// where it has changed (plus now and then, for slaves that
+// join late).  Its sequence number goes up with every change,
+// so a slave knows whether what it holds is current.
+//
+// Per event display toggles go as deltas: the master logs each
+// change in a short ring inside the block, numbered, and a
+// slave applies whichever it hasn't yet.  A slave that joins
+// late has missed the older ones, so the block also carries
+// the shown event's toggles in full, which a slave takes on
+// for that event whatever it's missed.  Nothing in here
+// depends on Syzygy.
+//********************************************************
+
+#ifndef SHAREDSTATE_H
+#define SHAREDSTATE_H
+
+#include <vector>
+#include "eventData.h"
+
+static const hkUint32 sharedStateVersion = 4;
+
+// one display toggle, particle 'particle' of event 'event' turned on or off
+struct displayChange {
+	hkUint32 sequence;
+	hkUint32 event;
+	hkUint32 particle;
+	hkUint32 on;
+};
+
+// The last few display toggles.  Room for more than a frame's worth, so a slave that's been there all along only
+// misses some if it misses frames.  One that joins later misses what came before, which the shown event's full
+// toggles (see shownDisplay) make up for as each event is shown.
+struct displayChannel {
+	enum { SLOTS = 16 };
+	hkUint32 latest;  //sequence of the newest change, 0 before there are any
+	displayChange slots[SLOTS];
+};
+
+// master: logs a toggle, overwriting the oldest
+void recordDisplayChange(displayChannel& channel, size_t event, size_t particle, bool on);
+// slave: the changes after 'applied', oldest first, moving 'applied' on past them.  False if some were already
+// overwritten, in which case the ones still there come back anyway.
+bool newDisplayChanges(const displayChannel& channel, hkUint32& applied, std::vector<displayChange>& changes);
+
+// The shown event's toggles, one bit a particle.  Particles past the first 'BITS' aren't carried.
+struct shownDisplay {
+	enum { BITS = 128 };
+	hkUint32 event;
+	hkUint32 particles;  //bits that are set from the event, 0 before there's one
+	hkUint32 bits[BITS / 32];
+};
+
+// master: puts event 'event''s toggles in 'shown'
+void packShownDisplay(shownDisplay& shown, size_t event, const std::vector<bool>& display);
+// slave: whether particle 'particle' is on in 'shown'.  Only for particles below shown.particles.
+inline bool shownDisplayOn(const shownDisplay& shown, size_t particle){
+	return (shown.bits[particle / 32] >> (particle % 32) & 1) != 0;
+}
+
+// flag bits
+enum {
+	STATE_MENU = 1 << 0,
+	STATE_MAIN_MENU = 1 << 1,
+	STATE_OPTIONS_MENU = 1 << 2,
+	STATE_CHERENKOV_MENU = 1 << 3,
+	STATE_COLOR_KEY = 1 << 4,
+	STATE_COLOR_BY_CHARGE = 1 << 5,
+	STATE_CYLINDER_DIVIDER = 1 << 6,
+	STATE_SCALE_BY_CHARGE = 1 << 7,
+	STATE_HIT_LABELS = 1 << 8,
+	STATE_TOUCHING_VERTEX = 1 << 9,
+	STATE_GRABBING_VERTEX = 1 << 10,
+	STATE_TRIGGER = 1 << 11,
+	STATE_SQUARE_HIGHLIGHTED = 1 << 12,
+	STATE_CHERENKOV_CONE = 1 << 13
+};
+
+struct sharedState {
+	hkUint32 version;   //sharedStateVersion, so a slave built from other sources doesn't misread it
+	hkUint32 sequence;  //counted up by the master whenever anything below changes
+	hkInt32 index;
+	hkInt32 autoPlay;
+	double currentTime;  //playback clock, in the event file's seconds
+	hkInt32 menuIndex;
+	hkInt32 optionsMenuPage;
+	hkInt32 cherenkovConeMenuIndex;
+	hkInt32 itemTouching;
+	hkUint32 flags;
+	hkInt32 pickedSet;   //the hit the wand's on: its set (-1 for none) and index in it
+	hkUint32 pickedHit;
+	float squareMatrix[16];
+	displayChannel display;
+	shownDisplay shown;
+};
+
+// Master side: sends the state when it changes, or every 'refreshFrames' frames regardless.
+class stateSender {
+public:
+	stateSender(int refreshFrames);
+	// 'next' is this frame's state, sequence aside.  True if it needs sending, with 'next' then numbered.
+	bool frame(sharedState& next);
+private:
+	sharedState last;
+	bool sentAny;
+	int refreshFrames;
+	int sinceSent;
+};
+
+#endif
@@ -9,10 +9,26 @@
 #define SZG_DO_NOT_EXPORT
 #include <stdio.h>
 #include <stdlib.h>
+#include <map>
 #include "arMasterSlaveFramework.h"
 #include "arInteractableThing.h"
 #include "arInteractionUtilities.h"
 #include "arGlut.h"
+#include "eventData.h"
+#include "eventBinary.h"
+#include "eventCache.h"
+#include "eventParser.h"
+#include "eventPayload.h"
+#include "sharedState.h"
+#include "frameTimer.h"
+#include "logger.h"
+#include "hitPrep.h"
+#include "hitPicker.h"
+#include "glEntryPoints.h"
+#include "hitRenderer.h"
+#include "hitLabels.h"
+#include "detectorMesh.h"
+#include "ringProjector.h"
 
 // Unit conversions.  Tracker (and cube screen descriptions) use feet.
 // Atlantis, for example, uses 1/2-millimeters, so the appropriate conversion
@@ -26,24 +42,14 @@ const double farClipDistance = 10000.*FEET_TO_LOCAL_UNITS;
 
 //contant values
 const double PI = 3.14159;
-double cherenkovElectronThreshold = .768; // in MeV
-double electronMass = 9.11e-31; //kilos  //ID -11 (11 = positron)
-double cherenkovMuonThreshold = 158.7; //MeV
-double muonMass = 1.88352473e-28; //kilos  //ID 13 (antiparticle = 13)
-double cherenkovPionThreshold = 209.7;  //MeV
-double pionMass = 2.483e-28;  //kilos  //ID is 211 / -211
-double speedOfLight = 299792458.; //in m/s
+int detectorSlices = 20;  //-detectorslices <n>: lines across and cross sections along the detector wireframe
 //Sizing Constants
 static double RADIUS = 17 * 3.28;     //Constants for sizing IN FEED
 static double HEIGHT = 40 * 3.28;
 static double OUTERRADIUS = 17.61 * 3.28;  
 static double OUTERHEIGHT = 41.22*  3.28;
-static double innerDotRad = 0.3 * 3.28;
-static double outerDotRad = 0.2 * 3.28;
 static double threshold = 1.;
 
-//master debug mode variable
-bool debug = true;
 //global function definitions (mostly utility)
 //definition of absolute value
 double abs(double in){
@@ -52,13 +58,6 @@ double abs(double in){
 	}
 	return in * -1.0;
 }
-//debug helper function
-void debugText(string s){
-	if(debug){
-		cout << s;
-		cout << "\n";
-	}
-}
 double magnitude(arVector3 a){
 	return sqrt(a[0]*a[0] + a[1]*a[1] + a[2]*a[2]);
 }
@@ -81,60 +80,20 @@ void drawDisplay(int index, bool highlighted, char * content[10],int numLines, i
 void doInterface(arMasterSlaveFramework& framework);
 bool updateMenuIndexState(int i);
 
-//Class Declarations:  
-class dot {  // The class containing all the relevant information about each dot
-public:
-	double cx, cy, cz, dx, dy, dz, charge, time, radius, number;
-	dot(double hit, double x, double y, double z, double xd, double yd, double zd, double q, double t, double r) {
-		number = hit;
-		cx = x * 3.28;
-		cy = y * 3.28;
-		cz = z * 3.28;
-		dx = xd;
-		dy = yd;
-		dz = zd;
-		charge = q;
-		time = t;
-		radius = r;
-	};
-	dot(){};
-	void draw(bool isOD);
-	arVector3 dotColor();
+//Class Declarations:  (dot and dotVector live in eventData.h)
+GLUquadricObj * quadObj = 0;  //quadric object for object drawing, one for every window
+
+// The GL objects one context (window) draws with.  What they draw, the events, hit transforms and colors and the
+// detector mesh, is worked out once per process and shared by every context.
+struct contextGL {
+	hitRenderer disks;       //the hit disks instanced, if the context can
+	meshRenderer detector;   //the tank wireframe
+	labelRenderer labels[2]; //the ID and OD hits' PMT numbers
+	unsigned hitsUploaded;   //hitsVersion and colorsVersion as of the last upload to 'disks'
+	unsigned colorsUploaded;
+	contextGL() : hitsUploaded(0), colorsUploaded(0) {}
 };
-
-typedef struct ringPointHolder{  //just a wrapped vector of arVector3s
-	vector<arVector3> ringPoints;
-}ringPointHolder;
-
-class dotVector {  //a dotVector is an individual event.
-public:
-	double startTime;
-	double endTime;
-	double length;
-	vector<double> particleType;  //each particleType as a double, which is encoded as GEANT particle code (http://hepunx.rl.ac.uk/BFROOT/www/Computing/Environment/NewUser/htmlbug/node51.html)
-	vector<string> particleName;  //just for ease of access, if we know what the type is (eg, muon electron pion) we'll write it in here, else we'll just enter "???"
-	vector<double> coneAngle;
-	vector<arVector3> coneDirection;
-	double vertexPosition[3];
-	vector<bool> haveRingPoints;
-	vector<bool> doDisplay;
-	vector<vector<ringPointHolder> > ringPoints;
-	vector<double> momentum;  //momentum (in MeV ? )
-	vector<double> energy; //in the case of time-compression (supernova file), each consecutive 3 entries in this will be vertex positions ... else, energy in MeV
-	vector<dot> dots;  //holds the inner cylinder
-	vector<dot> outerDots; //holds the outer cylinder
-	dotVector(vector<dot> in, vector<dot> outer, double st) {
-		dots = in;
-		outerDots = outer;
-		startTime = st;
-	};
-	dotVector(){};
-	void draw(arMasterSlaveFramework& fw);
-};
-
- 
-  
-GLUquadricObj * quadObj;  //quadric object for object drawing
+contextGL& currentGL();  //the current context's, set up the first time it's asked for
   
 // Class definitions & imlpementations. We'll have just one one class, a 2-ft colored square that
 // can be grabbed & dragged around. We'll also have an effector class for doing the grabbing
@@ -210,340 +169,27 @@ void RodEffector::draw() const {
 
 class Detector : public arInteractableThing {
 public:
-	arVector3 center; //for rendering
-	arVector3 axis; //for rendering
-	
-	//these used to make vertex array at initialization
-	double length;
-	double radius_upper;
-	double radius_lower;
-	double offset_upper;
-	double offset_lower;
-	double height;
-	
-	GLfloat * rectangle1;  //for top
-	GLfloat * rectangle2;  //for bottom
-	double num_slices_width_rectangle;
-	double num_slices_length_rectangle;
-	
-	GLfloat * circle1;  //for topleft/topright circlular piece
-	double num_slices_width_circle1;
-	double num_slices_length_circle1;
-	
-	GLfloat * circle2;  //for bottomleft / bottomright circlular piece
-	double num_slices_width_circle2;
-	double num_slices_length_circle2;
-	
-	GLfloat * cap;
-	//will automatically just join the lines of the surrounding pieces
+	detectorMesh mesh;  //the tank wireframe, worked out once and drawn from by every context
 	
 	Detector() : arInteractableThing() {}
-    ~Detector() {
-		delete [] rectangle1;
-		delete [] rectangle2;
-		delete [] circle1;
-		delete [] circle2;
-	}
 	
-	void initialize(); //populates vertex arrays
+	void initialize(); //builds the wireframe.  Needs no GL.
     void draw( arMasterSlaveFramework* fw=0 );
 };
 
-void Detector::initialize(){  //will be drawn going down z axis, with up being y
-	debugText("Started detector initialization");
-	//tunable parameters
-	num_slices_width_rectangle = 20;
-	num_slices_length_rectangle = 20;
-	num_slices_length_circle1 = 20;
-	num_slices_width_circle1 = 20;
-	num_slices_length_circle2 = 20;
-	num_slices_width_circle2 = 20;
-	
-	//constant sizing parameters
-	length = 49.500 * 3.28;
-	radius_upper   = 32 * 3.28;
-	radius_lower   = 30 * 3.28;
-	height = 48 * 3.28;
-	offset_upper =  8 * 3.28;
-	offset_lower =  6 * 3.28;
-	
-	//pack vertex arrays for all the diff parts ... one for top/bottom, one for topleft / topright, one for bottomleft/bottomright, one for end caps
-	//these will be placed such that 0,0,0 is at the "top left" corner (I have no better way to say it)
-	
-	//fill rectangle with length_slices + width_slices lines = 2 * size(FLOAT) in size
-	//rectangle1 = new GLfloat(3 * (2 * num_slices_width_rectangle + 2 * num_slices_length_rectangle));
-	rectangle1 = (GLfloat*) malloc(4 * 3 * (2 * num_slices_width_rectangle + 2 * num_slices_length_rectangle) );
-	int addressCounter = 0;
-	float holder_length = sqrt(radius_upper*radius_upper - height * height / 4);
-	float rtop = holder_length - offset_upper;
-	float width = 2*rtop;
-	for(int i = 0; i < 3 * (2 * num_slices_width_rectangle + 2 * num_slices_length_rectangle); i++){ //clear array
-		rectangle1[i] = 0;
-	} 
-	for(float i = 0; i <= width; i+= width/(num_slices_width_rectangle - 1)){
-		//i denotes a location in x
-		rectangle1[addressCounter] = i;
-		rectangle1[addressCounter + 1] = 0; 
-		rectangle1[addressCounter + 2] = 0;
-		rectangle1[addressCounter + 3] = i;
-		rectangle1[addressCounter + 4] = 0;
-		rectangle1[addressCounter + 5] = length;
-		addressCounter += 6;
-	}
-	for(float i = 0; i <= length; i+= length/(num_slices_length_rectangle - 1)){
-		//i denotes a location in z
-		rectangle1[addressCounter] = 0;
-		rectangle1[addressCounter + 1] = 0; 
-		rectangle1[addressCounter + 2] = i;
-		rectangle1[addressCounter + 3] = width;
-		rectangle1[addressCounter + 4] = 0;
-		rectangle1[addressCounter + 5] = i;
-		addressCounter += 6;
-	} //*/
-	
-	//fill rectangle with length_slices + width_slices lines = 2 * size(FLOAT) in size
-	//rectangle1 = new GLfloat(3 * (2 * num_slices_width_rectangle + 2 * num_slices_length_rectangle));
-	rectangle2 = (GLfloat*) malloc(4 * 3 * (2 * num_slices_width_rectangle + 2 * num_slices_length_rectangle) );
-	addressCounter = 0;
-	holder_length = sqrt(radius_lower*radius_lower - height * height / 4);
-	float rbottom = holder_length - offset_lower;
-	width = 2*rbottom;
-	for(int i = 0; i < 3 * (2 * num_slices_width_rectangle + 2 * num_slices_length_rectangle); i++){ //clear array
-		rectangle2[i] = 0;
-	} 
-	for(float i = 0; i <= width; i+= width/(num_slices_width_rectangle - 1)){
-		//i denotes a location in x
-		rectangle2[addressCounter] = i;
-		rectangle2[addressCounter + 1] = 0; 
-		rectangle2[addressCounter + 2] = 0;
-		rectangle2[addressCounter + 3] = i;
-		rectangle2[addressCounter + 4] = 0;
-		rectangle2[addressCounter + 5] = length;
-		addressCounter += 6;
-	}
-	for(float i = 0; i <= length; i+= length/(num_slices_length_rectangle - 1)){
-		//i denotes a location in z
-		rectangle2[addressCounter] = 0;
-		rectangle2[addressCounter + 1] = 0; 
-		rectangle2[addressCounter + 2] = i;
-		rectangle2[addressCounter + 3] = width;
-		rectangle2[addressCounter + 4] = 0;
-		rectangle2[addressCounter + 5] = i;
-		addressCounter += 6;
-	} //*/
-	
-	
-	//now for circle1
-	int size = 3 * (2 * num_slices_width_circle1 + 2 * num_slices_length_circle1 * num_slices_width_circle1);
-	circle1 = (GLfloat*) malloc(4 * size );
-	addressCounter = 0;
-	for (int i = 0; i < size; i++){
-		circle1[i] = 0;
-	}
-	float phi = asin(height / 2 / radius_upper);
-	for(float i = 0; i <= phi; i += phi / (num_slices_width_circle1 - 1)){
-		float xval = cos(i) * radius_upper;
-		float yval = sin(i) * radius_upper;
-		circle1[addressCounter] = xval - offset_upper;
-		circle1[addressCounter + 1] = yval; 
-		circle1[addressCounter + 2] = 0;
-		circle1[addressCounter + 3] = xval - offset_upper;
-		circle1[addressCounter + 4] = yval;
-		circle1[addressCounter + 5] = length;
-		addressCounter += 6;
-	}
-	for(float i = 0; i <= length; i += length / (num_slices_length_circle1 - 1 )){
-		float lastX = radius_upper - offset_upper;
-		float lastY = 0;
-		for(float j = phi / (num_slices_width_circle1 - 1); j <= phi; j += phi / (num_slices_width_circle1 - 1)){
-			float xval = cos(j) * radius_upper;
-			float yval = sin(j) * radius_upper;
-			circle1[addressCounter] = xval - offset_upper;
-			circle1[addressCounter + 1] = yval; 
-			circle1[addressCounter + 2] = i;
-			circle1[addressCounter + 3] = lastX;
-			circle1[addressCounter + 4] = lastY;
-			circle1[addressCounter + 5] = i;
-			addressCounter += 6;
-			lastX = xval - offset_upper;
-			lastY = yval;
-		}
-	}
-	
-	//now for circle2
-	size = 3 * (2 * num_slices_width_circle2 + 2 * num_slices_length_circle2 * num_slices_width_circle2);
-	circle2 = (GLfloat*) malloc(4 * size );
-	addressCounter = 0;
-	for (int i = 0; i < size; i++){
-		circle2[i] = 0;
-	}
-	phi = asin(height / 2 / radius_lower);
-	for(float i = 0; i <= phi; i += phi / (num_slices_width_circle2 - 1)){
-		float xval = cos(i) * radius_lower;
-		float yval = -sin(i) * radius_lower;
-		circle2[addressCounter] = xval - offset_lower;
-		circle2[addressCounter + 1] = yval; 
-		circle2[addressCounter + 2] = 0;
-		circle2[addressCounter + 3] = xval - offset_lower;
-		circle2[addressCounter + 4] = yval;
-		circle2[addressCounter + 5] = length;
-		addressCounter += 6;
-	}
-	for(float i = 0; i <= length; i += length / (num_slices_length_circle2 - 1 )){
-		float lastX = radius_lower - offset_lower;
-		float lastY = 0;
-		for(float j = phi / (num_slices_width_circle2 - 1); j <= phi; j += phi / (num_slices_width_circle2 - 1)){
-			float xval = cos(j) * radius_lower;
-			float yval = -sin(j) * radius_lower;
-			circle2[addressCounter] = xval - offset_lower;
-			circle2[addressCounter + 1] = yval; 
-			circle2[addressCounter + 2] = i;
-			circle2[addressCounter + 3] = lastX;
-			circle2[addressCounter + 4] = lastY;
-			circle2[addressCounter + 5] = i;
-			addressCounter += 6;
-			lastX = xval - offset_lower;
-			lastY = yval;
-		}
-	}
-	
-	
-	
-	//now for end caps!
-	size = 3 * (2 * num_slices_width_rectangle + 2 * num_slices_width_circle1 + 2 * num_slices_width_circle2  + 4 * num_slices_width_circle1);
-	cap = (GLfloat*) malloc(4 * size);
-	addressCounter = 0;
-	for(int i = 0; i < size; i++){
-		cap[i] = 0;
-	}
-	for(float i = 0; i < num_slices_width_rectangle; i++){
-		cap[addressCounter] = i*2*rtop / (num_slices_width_rectangle - 1) - rtop;
-		cap[addressCounter + 1] = height/2; 
-		cap[addressCounter + 2] = 0;
-		cap[addressCounter + 3] = 2*i*rbottom / (num_slices_width_rectangle - 1) - rbottom;
-		cap[addressCounter + 4] = -height/2;
-		cap[addressCounter + 5] = 0;
-		addressCounter += 6;
-	}
-	phi = asin(height / 2 / radius_upper);
-	float phi_upper = phi;
-	for(float i = 0; i <= phi; i += phi / (num_slices_width_circle1 - 1)){
-		float xval = cos(i) * radius_upper;
-		float yval = sin(i) * radius_upper;
-		cap[addressCounter] = xval - offset_upper;
-		cap[addressCounter + 1] = yval; 
-		cap[addressCounter + 2] = 0;
-		cap[addressCounter + 3] = -xval + offset_upper;
-		cap[addressCounter + 4] = yval;
-		cap[addressCounter + 5] = 0;
-		addressCounter += 6;
-	}
-	phi = asin(height / 2 / radius_lower);
-	float phi_lower = phi;
-	for(float i = 0; i <= phi; i += phi / (num_slices_width_circle2 - 1)){
-		float xval = cos(i) * radius_lower;
-		float yval = -sin(i) * radius_lower;
-		cap[addressCounter] = xval - offset_lower;
-		cap[addressCounter + 1] = yval; 
-		cap[addressCounter + 2] = 0;
-		cap[addressCounter + 3] = -xval + offset_lower;
-		cap[addressCounter + 4] = yval;
-		cap[addressCounter + 5] = 0;
-		addressCounter += 6;
-	}
-	for(float i = 0; i < num_slices_width_circle1; i++){
-		float xval_upper = cos( phi_upper * i / (num_slices_width_circle1 - 1)) * radius_upper;
-		float yval_upper = sin( phi_upper * i / (num_slices_width_circle1 - 1)) * radius_upper;
-		float xval_lower = cos( phi_lower * i / (num_slices_width_circle1 - 1)) * radius_lower;
-		float yval_lower = -sin( phi_lower * i / (num_slices_width_circle1 - 1)) * radius_lower;
-		cap[addressCounter] = xval_upper - offset_upper;
-		cap[addressCounter + 1] = yval_upper; 
-		cap[addressCounter + 2] = 0;
-		cap[addressCounter + 3] = xval_lower - offset_lower;
-		cap[addressCounter + 4] = yval_lower;
-		cap[addressCounter + 5] = 0;
-		addressCounter += 6;
-	}
-	for(float i = 0; i < num_slices_width_circle1; i++){
-		float xval_upper = cos( phi_upper * i / (num_slices_width_circle1 - 1)) * radius_upper;
-		float yval_upper = sin( phi_upper * i / (num_slices_width_circle1 - 1)) * radius_upper;
-		float xval_lower = cos( phi_lower * i / (num_slices_width_circle1 - 1)) * radius_lower;
-		float yval_lower = sin( phi_lower * i / (num_slices_width_circle1 - 1)) * radius_lower;
-		cap[addressCounter] = -xval_upper + offset_upper;
-		cap[addressCounter + 1] = yval_upper; 
-		cap[addressCounter + 2] = 0;
-		cap[addressCounter + 3] = -xval_lower + offset_lower;
-		cap[addressCounter + 4] = -yval_lower;
-		cap[addressCounter + 5] = 0;
-		addressCounter += 6;
-	}
-	
-
-	
-	debugText("ended detector initialization \n");
+void Detector::initialize(){
+	mesh.build(detectorSlices, detectorSlices);
 }
 void Detector::draw(arMasterSlaveFramework* fw){
-	debugText("Started detector draw");
+	HK_TIME_PHASE(PHASE_DRAW_DETECTOR);
+	glColor3f(1,1,1);
+	//marker at the +z end of the tank
 	glPushMatrix();
-		//offet to get us placed properly
+		glTranslatef(0,0,detectorMesh::length() / 2);
 		glRotatef(180, 0, 1, 0);
-		glTranslatef(0,0,-length/2);
-		glColor3f(1,1,1);
 		glutSolidSphere(5,5,5);
-		//draw detector
-		glEnableClientState(GL_VERTEX_ARRAY);
-		//draw top
-		glPushMatrix();
-			float holder_length = sqrt(radius_upper*radius_upper - height * height / 4);
-			float rtop = holder_length - offset_upper;
-			glTranslatef(-rtop, height / 2, 0);
-			glVertexPointer(3, GL_FLOAT, 0, rectangle1);
-			glDrawArrays(GL_LINES, 0, num_slices_width_rectangle * 2 + num_slices_length_rectangle * 2);
-		glPopMatrix();
-		
-		//draw bottom
-		glPushMatrix();
-			holder_length = sqrt(radius_lower*radius_lower - height * height / 4);
-			float rbottom = holder_length - offset_lower;
-			glTranslatef((-radius_upper + offset_upper) / 2, - height / 2, 0);
-			glVertexPointer(3, GL_FLOAT, 0, rectangle2);
-			glDrawArrays(GL_LINES, 0, num_slices_width_rectangle * 2 + num_slices_length_rectangle * 2);
-		glPopMatrix();
-		
-		//draw upper circles
-		glPushMatrix();
-			glVertexPointer(3, GL_FLOAT, 0, circle1);
-			glDrawArrays(GL_LINES, 0, (2 * num_slices_width_circle1 + 2 * num_slices_length_circle1 * num_slices_width_circle1));
-			glRotatef(180, 0, 1, 0);
-			glTranslatef(0,0,-length);
-			glDrawArrays(GL_LINES, 0, (2 * num_slices_width_circle1 + 2 * num_slices_length_circle1 * num_slices_width_circle1));
-		glPopMatrix();
-		
-		//draw upper circles
-		glPushMatrix();
-			glVertexPointer(3, GL_FLOAT, 0, circle2);
-			glDrawArrays(GL_LINES, 0, (2 * num_slices_width_circle2 + 2 * num_slices_length_circle2 * num_slices_width_circle2));
-			glRotatef(180, 0, 1, 0);
-			glTranslatef(0,0,-length);
-			glDrawArrays(GL_LINES, 0, (2 * num_slices_width_circle2 + 2 * num_slices_length_circle2 * num_slices_width_circle2));
-		glPopMatrix();
-		
-		glPushMatrix();
-			glVertexPointer(3, GL_FLOAT, 0, cap);
-			glDrawArrays(GL_LINES, 0, (2 * num_slices_width_rectangle + 2 * num_slices_width_circle1 + 2 * num_slices_width_circle2  + 4 * num_slices_width_circle1));
-			
-			glTranslatef(0,0,length);
-			glDrawArrays(GL_LINES, 0, (2 * num_slices_width_rectangle + 2 * num_slices_width_circle1 + 2 * num_slices_width_circle2  + 4 * num_slices_width_circle1));
-		glPopMatrix();
-		
-		
-		
-		
-		
-		//fin with drawing detector
-		glDisableClientState(GL_VERTEX_ARRAY);
 	glPopMatrix();
-	debugText("ended detector draw \n");
+	currentGL().detector.draw();
 }
 
 // End of classes
@@ -558,40 +204,87 @@ bool doHUD = false;  //outdated
 bool doMenu = true;  //whether or not the menu is currently displayed
 bool doMainMenu = true; 
 bool doOptionsMenu = false;
+int optionsMenuPage = 0;  //the options menu has two pages of toggles
 bool doLoadMenu = false;
 bool doCherenkovConeMenu = false;
 bool triggerDepressed = false;
+#ifdef HK_PROFILE
+bool showFrameTimes = false;  //'t' shows the frame time percentiles next to the tablet
+string frameTimesText;        //what's shown, refreshed twice a second
+double frameTimesShown = 0;
+#endif
 int cherenkovConeMenuIndex = 0;  //there will be (num charenkov cones) / 3 submenus if the number of cherenkov cones is greated than 4
 int menuIndex = 0;  //current index in the menu, defaults to 0 .. can be -2,-1,0,1,2 for 5 windows
 bool doColorKey = false;  //window next to the primary tablet with information for charge or time display ... not currently implemented
-int modifiedCherenkovConeIndex = -1;  //if we modify a cone index, instead of sharing the entire doDisplay vector, we'll change this to a value 0 - doDisplay.size()-1.  If it's -1, no change
 
 bool doCherenkovCone = true;   //toggle for cherenkov cones lines connecting particle to projection on wall.
 bool doScaleByCharge = true;   //scales the radii of circles by their respective charges.  Hard coded scale factor at the moment.
-double currentTime = 0.0;
-double timeScaleFactor = .5;  //scale factor for playback.  At 1, length of the supernova is 7 seconds.  There's a bug or me being stupid somewhere that's requiring this to not be 1.0.
-double timeHolder1 = 0.0;
+double currentTime = 0.0;     //playback clock, in the event file's seconds.  Playback shows the event whose end time it's coming up to
+double timeScaleFactor = .5;  //-playrate <x>: event file seconds played each second
+double timeHolder1 = 0.0;     //when (seconds) playback last stepped
 bool doCylinderDivider = true;  //do outer detector true/false
-int autoPlay = 0;   //autoplay back = -1, autoplay forward = 1;
+int autoPlay = 0;   //autoplay back = -1, autoplay forward = 1; while it's on, hits only show once the clock reaches them
 double lastJoyStickMove = 0;  //last time the joystick was moved, used for double-press activation, not currently working
 bool joyStickMoveDir = true;  //last joystick move direction, true = right, false = left, not implemented
 double ax, az;
 int index;  //current location in the event list
 int indexTransfer;  
 vector<dotVector> dotVectors;     //Vector to hold all generated dot vectors in loaded order
-dotVector currentDots;               //Class to hold unknown number of dots (just wraps the dotVector)
+dotVector* currentDots = 0;          //the event being shown, points in to dotVectors (or the stream cache) so it's never copied
+size_t currentIndex = 0;             //index currentDots was fetched for
+hitTransforms innerTransforms, outerTransforms;  //disk placement for currentDots' hits
+bool hitTransformsReady = false;     //cleared whenever currentDots changes
+unsigned hitsVersion = 0, colorsVersion = 0;  //counted up whenever the transforms or the colors are recomputed
+bool preparedScaleByCharge, preparedTimeCompressed;  //options the transforms were computed with
+hitCells innerCells, outerCells;     //currentDots' hits bucketed round and along the detector, for culling
+const int cellsAround = 32, cellsAlong = 16;
+vector<hitRun> visibleHits;          //scratch, the runs of hits in view
+//a viewport, x y width height, as a map key
+struct viewportKey {
+	GLint v[4];
+	bool operator<(const viewportKey& other) const {
+		for(int k = 0; k < 4; k++){
+			if(v[k] != other.v[k]){
+				return v[k] < other.v[k];
+			}
+		}
+		return false;
+	}
+};
+map<viewportKey, cullStats> viewCulling;  //what culling left to draw at each viewport, last frame
+colorScales hitScales;               //-colors <file>: charge and time color steps, the original ones unless given
+hitColors currentColors;             //packed hit colors for currentDots
+bool preparedColorByCharge;          //option the colors were computed with
+map<const void*, contextGL*> contexts;  //by currentContext()
+hitLabels innerLabels, outerLabels;  //PMT numbers for currentDots' hits
+hitPicker innerPicker, outerPicker;  //currentDots' hits gridded for the wand to pick from
+int pickedSet = -1;                  //hitRenderer set of the hit the wand's on, -1 for none
+size_t pickedHit = 0;                //and its index in that set
+const float pickRange = 1.5;         //feet from the wand's tip a hit is picked at, before trying where it points
+const float pickReach = 1000;        //feet the wand points out to
+bool doHitLabels = true;             //whether hits near the viewer or wand show their PMT numbers
+double labelRange = 10;              //-labels <feet>: how near a hit has to be for its label to show
 arVector3 currentPosition;
 double viewer_distance=100.0;
 double viewer_angle=0.0;
 bool l_button=false;
 bool r_button=false;
 arVector3 l_position;
-dot tempDot;                    //dot held between loading new events. This is a one-dot buffer
-bool stored = false;            //Telling us whether a dot is stored in tempDot
 bool colorByCharge = false;      //whether to color by charge or time
-ifstream dataFile;              //data input
+mappedEventFile eventFile;      //binary (.hkev) data input, mapped for the life of the program
 char* filename;
-bool doTimeCompressed = false;
+size_t streamBudget = 0;        //-stream <MB>: if set, events are decoded on demand and kept within this many bytes instead of all loaded up front
+size_t streamWindow = 4;        //-window <n>: events either side of the current one decoded ahead of time when streaming
+eventCache* streamedEvents = 0;
+size_t distributeBytes = 0;     //-distribute <KB>: only the master reads the file, sending slaves the events they need, at most this much a frame
+eventSender* sentEvents = 0;    //the master's end of that
+eventReceiver* receivedEvents = 0;  //a slave's
+ringWorkers* coneRings = 0;     //works out the cone rings on the tank wall in the background
+const size_t ringWindow = 2;    //events either side of the current one whose rings are worked out ahead of time
+vector<char> eventMessage;      //this frame's events for the slaves
+unsigned parseThreads = 0;      //-threads <n>: threads used to parse text files, 0 for one per core
+bool doTimeCompressed = false;   //-timestep <seconds>: merge events in to bins this long (supernova files)
+double timeStep = .05;
 arVector3 deltaPosition, originalPosition;
 arVector3 deltaDirection, originalDirection;
 bool isTouchingVertex = false;
@@ -600,152 +293,294 @@ int itemTouching = 0;  //0 corresponds to vertex, else subtract 1 and is index o
 arVector3 vertexOffset;
 //string bufferLine;  
 
+//the event list, whether it's all in dotVectors, streamed or sent from the master
+size_t numEvents(){
+	if(receivedEvents){
+		return receivedEvents->size();
+	}
+	return streamedEvents ? streamedEvents->size() : dotVectors.size();
+}
+dotVector& eventAt(size_t i){
+	if(receivedEvents){
+		return receivedEvents->get(i);
+	}
+	return streamedEvents ? streamedEvents->get(i) : dotVectors[i];
+}
+//end time of event i, known without loading it (master only)
+double eventEndTime(size_t i){
+	return streamedEvents ? streamedEvents->endTime(i) : dotVectors[i].endTime;
+}
+//the event shown at time t: the first to end after it, or the last
+size_t eventAtTime(double t){
+	size_t low = 0, high = numEvents() - 1;
+	while(low < high){
+		size_t middle = (low + high) / 2;
+		if(eventEndTime(middle) > t){
+			high = middle;
+		}
+		else{
+			low = middle + 1;
+		}
+	}
+	return low;
+}
+
+//plays forward (1) or back (-1), from the start or end of the event shown if playback wasn't already going, or stops (0)
+void setPlayback(int direction){
+	if(direction != 0 && autoPlay == 0 && currentDots){
+		currentTime = direction > 0 ? currentDots->startTime : currentDots->endTime;
+	}
+	autoPlay = direction;
+}
 
+//moves the playback clock on by the time since the last frame and shows the event it's reached.  Stops at either end
+//of the file.
+void stepPlayback(arMasterSlaveFramework& fw){
+	double now = fw.getTime() / 1000;
+	double elapsed = min(now - timeHolder1, .25);  //a long frame doesn't jump ahead
+	timeHolder1 = now;
+	if(autoPlay == 0 || numEvents() == 0){
+		return;
+	}
+	currentTime += autoPlay * elapsed * timeScaleFactor;
+	//the loaders start the first event at 0, so that isn't looked up (which could decode it)
+	double first = 0, last = eventEndTime(numEvents() - 1);
+	if(currentTime >= last || currentTime <= first){
+		currentTime = min(max(currentTime, first), last);
+		autoPlay = 0;
+	}
+	index = (int)eventAtTime(currentTime);
+}
 
-//function definitions
-//returns color of dots based on whether charge or time are the metrics for coloring, based on these color arrays
-//PRE_PICKED COLOR ARRAYS
-int red_values [] =		{132	,74,	22,		4,		4,		6,		40,		115,	193,	249,	253,	249,	219,	219,	219,	219};  //r
-int green_values [] =	{4		,12,	4,		124,	175,	184,	183,	114,	193,	249,	213,	191,	143,	129,	102,	33};    //g
-int blue_values [] =	{186	,178,	186,	186,	186,	86,		7,		0,		6,		21,		80,		1,		12,		12,		12,		12};   //b
-arVector3 dot::dotColor() {
-	double red, green, blue;
-	double numDivs = 16;
-	int section = 0;
-	if(colorByCharge) {
-		double value = charge;
-		if(value > 26.7) section = 15;
-		else if (value > 23.3) section = 14;
-		else if (value > 20.2) section = 13;
-		else if (value > 17.3) section = 12;
-		else if (value > 14.7) section = 11;
-		else if (value > 12.2) section = 10;
-		else if (value > 10) section = 9;
-		else if (value > 8.0) section = 8;
-		else if (value > 6.2) section = 7;
-		else if (value > 4.7) section = 6;
-		else if (value > 3.3) section = 5;
-		else if (value > 2.2) section = 4;
-		else if (value > 1.3) section = 3;
-		else if (value > 0.7) section = 2;
-		else if (value > 0.2) section = 1;
-
-		red = red_values[section] / 255.0;
-		blue = blue_values[section] / 255.0;
-		green = green_values[section] / 255.0;
-	} else {
-		double value = time;
-		/*
-		if(value > 1125) section = 16;
-		else if (value > 1110) section = 14;
-		else if (value > 1095) section = 13;
-		else if (value > 1080) section = 12;
-		else if (value > 1065) section = 11;
-		else if (value > 1050) section = 10;
-		else if (value > 1035) section = 9;
-		else if (value > 1020) section = 8;
-		else if (value > 1005) section = 7;
-		else if (value > 990) section = 6;
-		else if (value > 975) section = 5;
-		else if (value > 960) section = 4;
-		else if (value > 945) section = 3;
-		else if (value > 930) section = 2;
-		else if (value > 915) section = 1;
-		*/
-		/*
-		if(value < 1001) section = 16;
-		else if (value < 1012) section = 14;
-		else if (value < 1023) section = 13;
-		else if (value < 1034) section = 12;
-		else if (value < 1045) section = 11;
-		else if (value < 1056) section = 10;
-		else if (value < 1067) section = 9;
-		else if (value < 1078) section = 8;
-		else if (value < 1089) section = 7;
-		else if (value < 1100) section = 6;
-		else if (value < 1111) section = 5;
-		else if (value < 1122) section = 4;
-		else if (value < 1133) section = 3;
-		else if (value < 1144) section = 2;
-		else if (value < 1155) section = 1;
-		*/
-		if(value < 893) section = 15;
-		else if (value < 909) section = 14;
-		else if (value < 925) section = 13;
-		else if (value < 941) section = 12;
-		else if (value < 957) section = 11;
-		else if (value < 973) section = 10;
-		else if (value < 989) section = 9;
-		else if (value < 1005) section = 8;
-		else if (value < 1021) section = 7;
-		else if (value < 1037) section = 6;
-		else if (value < 1053) section = 5;
-		else if (value < 1069) section = 4;
-		else if (value < 1085) section = 3;
-		else if (value < 1101) section = 2;
-		else if (value < 1117) section = 1;
-
-		//now we will access an array of pre-picked values corresponding with the superscan mode, based on the SECTION
-		red = red_values[section] / 255.0;
-		blue = blue_values[section] / 255.0;
-		green = green_values[section] / 255.0;
-	}
-	return arVector3(red,green,blue);
+//the latest hit time shown in an event while playing.  The hits' times are spread over the event's span of the clock,
+//so its hits come in from the earliest to the latest as the clock crosses it.
+double playbackHitTime(const dotVector& event, const hitCells& inner, const hitCells& outer){
+	if(autoPlay == 0){
+		return HUGE_VAL;
+	}
+	float earliest = inner.earliest, latest = inner.latest;
+	if(inner.order.empty()){
+		earliest = outer.earliest;
+		latest = outer.latest;
+	}
+	else if(!outer.order.empty()){
+		earliest = min(earliest, outer.earliest);
+		latest = max(latest, outer.latest);
+	}
+	double span = event.endTime - event.startTime;
+	double played = span > 0 ? (currentTime - event.startTime) / span : 1;
+	played = min(max(played, 0.0), 1.0);
+	return earliest + played * (latest - earliest);
 }
-void dot::draw(bool isOD){
-	//cout << cx / 30.48 << " " << cy / 30.48 << " " << cz / 30.48 << "\n";
-	//if(cy > 0 && dy < 0){
-	//	cout <<"HIT:" << number << "|" << cx << " " << cy << " " << cz << " | " << dx << " " << dy << " " << dz << "\n";
-	//}
-	glPushMatrix();
-		double radius = innerDotRad;
-		double radiusScaleFactor = 1.;
-		if(doScaleByCharge && abs(charge) < 26.7){
-			double scaleMin = .5;
-			if(doTimeCompressed){
-				scaleMin = .25;
-			}
-			radiusScaleFactor = scaleMin/26.7 * charge + scaleMin;
-			radius = radius * radiusScaleFactor;
+
+void setEventDisplay(size_t event, size_t particle, bool on){
+	if(receivedEvents){
+		//one that isn't here comes with the master's toggles when it's sent
+		if(receivedEvents->has(event) && particle < receivedEvents->get(event).doDisplay.size()){
+			receivedEvents->get(event).doDisplay[particle] = on;
 		}
-		//translate to right position and rotation
-		glTranslatef(cx / 100, cy / 100, -cz / 100);
-		//current direction is -z, want to rotate to vector <dx, dy, dz>
-		arVector3 currentDir(0,0,-1);
-		arVector3 targetDir = normalize(arVector3(dx,dy,dz));
-		if(! (abs(dotProduct(targetDir, currentDir)) >= .99)){  //in case of end caps, don't need any rotation (trying to would break it)
-			arVector3 axisRotation = crossProduct(currentDir, targetDir);
-			double angle = acos(dotProduct(axisRotation, currentDir))*180/PI;
-			
-			glRotatef(angle, axisRotation[0], axisRotation[1], axisRotation[2]);
+	}
+	else if(streamedEvents){
+		streamedEvents->setDisplay(event, particle, on);
+	}
+	else{
+		dotVectors[event].doDisplay[particle] = on;
+	}
+}
+
+bool hasRings(const dotVector& event){
+	for(size_t p = 0; p < event.haveRingPoints.size(); p++){
+		if(!event.haveRingPoints[p]){
+			return false;
 		}
-		
-		//test...move in direction of negative Z axis
-		//glTranslatef(0,0,-5);
-		
-		arVector3 myColor = dotColor();
-		glColor3f(myColor[0], myColor[1], myColor[2]);
-		gluDisk(quadObj,0,radius,20,1);
-		glColor3f(1,1,1);
-		glScalef(.001,.001,.001);
-		glLineWidth(4);
-		int n = 123;
-		char text[100]	;
-		sprintf(text, "%d", (int) number);
-		for (char * p = text; *p; p++)
-			glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
+	}
+	return true;
+}
+
+//asks for the rings of the events round the current one, only those already here so nothing's loaded for them, and
+//picks up the current event's once they're done.  Never waits on the workers.
+void updateRings(){
+	if(!doCherenkovCone || !currentDots || !coneRings){
+		return;
+	}
+	coneRings->setCurrent(currentIndex);
+	size_t first = currentIndex > ringWindow ? currentIndex - ringWindow : 0;
+	for(size_t i = first; i <= currentIndex + ringWindow && i < numEvents(); i++){
+		bool here = receivedEvents ? receivedEvents->has(i) : !streamedEvents || streamedEvents->has(i);
+		if(here && !hasRings(eventAt(i))){
+			coneRings->request(i, eventAt(i));
+		}
+	}
+	if(!hasRings(*currentDots)){
+		coneRings->fill(currentIndex, *currentDots);
+	}
+}
+
+
+
+//draws the disk for hit i of a set, placed by its precomputed transform.  Only used when the context can't draw instanced.
+void drawHitDisk(const hitTransforms& transforms, const vector<hkUint32>& colors, size_t i){
+	glPushMatrix();
+		glMultMatrixf(transforms.matrix(i));
+		glColor4ubv((const GLubyte*)&colors[i]);
+		gluDisk(quadObj,0,transforms.radius[i],20,1);
 	glPopMatrix();
 }
 
-void dotVector::draw(arMasterSlaveFramework& fw){
-	debugText("Began Draw Dots");
-	for(std::vector<dot>::size_type i = 0; i != currentDots.dots.size(); i++) {
-		currentDots.dots[i].draw(false);
+contextGL& currentGL(){
+	contextGL*& context = contexts[currentContext()];
+	if(!context){
+		context = new contextGL;
+		//instanced hit disks, falling back to a gluDisk per hit on contexts without instancing
+		if(!context->disks.init(20)){
+			HK_LOG(LOG_WARN, "%s", context->disks.error().c_str());
+		}
+		context->detector.init(myDetector.mesh);
+	}
+	return *context;
+}
+
+//draws the hits of one set that are in cells the frustum can see
+void drawHitSet(hitRenderer& disks, int set, const hitTransforms& transforms, const hitCells& cells, const vector<hkUint32>& colors, const viewFrustum& frustum, double until, cullStats& stats){
+	visibleRuns(cells, frustum, visibleHits, stats, until);
+	if(disks.isReady()){
+		disks.draw(set, visibleHits);
+		return;
+	}
+	for(size_t r = 0; r < visibleHits.size(); r++){
+		for(size_t k = visibleHits[r].first; k < visibleHits[r].first + visibleHits[r].count; k++){
+			drawHitDisk(transforms, colors, cells.order[k]);
+		}
+	}
+}
+
+void dotVector::draw(arMasterSlaveFramework& /*fw*/){
+	HK_TIME_PHASE(PHASE_DRAW_DOTS);
+	HK_LOG_EVERY(LOG_TRACE, 1.0, "began drawing dots");
+	hitColumnsView inner = innerHits();
+	hitColumnsView outer = outerHits();
+	//hits don't move, so their transforms are only redone for a new event or a change to the scaling options
+	bool newTransforms = !hitTransformsReady || preparedScaleByCharge != doScaleByCharge || preparedTimeCompressed != doTimeCompressed;
+	if(newTransforms){
+		//both cylinders have always been drawn at the inner disk size
+		innerTransforms.compute(inner, innerDotRad, doScaleByCharge, doTimeCompressed);
+		outerTransforms.compute(outer, innerDotRad, doScaleByCharge, doTimeCompressed);
+		innerCells.compute(innerTransforms, inner.time, cellsAround, cellsAlong);
+		outerCells.compute(outerTransforms, outer.time, cellsAround, cellsAlong);
+		hitsVersion++;
+		innerLabels.build(inner, innerTransforms);
+		innerPicker.build(innerTransforms, inner.time);
+		outerPicker.build(outerTransforms, outer.time);
+		outerLabels.build(outer, outerTransforms);
+		preparedScaleByCharge = doScaleByCharge;
+		preparedTimeCompressed = doTimeCompressed;
+	}
+	//same for colors, which only change with the event (auto ranged scales follow it) or the coloring option
+	if(newTransforms || preparedColorByCharge != colorByCharge){
+		currentColors.compute(inner, outer, hitScales, colorByCharge);
+		colorsVersion++;
+		preparedColorByCharge = colorByCharge;
+	}
+	hitTransformsReady = true;
+	//each context keeps its own copy in GL, brought up to date the first time it draws after a change
+	contextGL& context = currentGL();
+	if(context.hitsUploaded != hitsVersion){
+		context.disks.uploadTransforms(hitRenderer::INNER_HITS, innerTransforms, innerCells.order);
+		context.disks.uploadTransforms(hitRenderer::OUTER_HITS, outerTransforms, outerCells.order);
+		context.hitsUploaded = hitsVersion;
+	}
+	if(context.colorsUploaded != colorsVersion){
+		context.disks.uploadColors(hitRenderer::INNER_HITS, inner.count ? &currentColors.inner[0] : 0, inner.count, innerCells.order);
+		context.disks.uploadColors(hitRenderer::OUTER_HITS, outer.count ? &currentColors.outer[0] : 0, outer.count, outerCells.order);
+		context.colorsUploaded = colorsVersion;
+	}
+
+	//only the cells this eye's frustum can see get drawn
+	GLfloat projection[16], modelview[16];
+	glGetFloatv(GL_PROJECTION_MATRIX, projection);
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+	viewFrustum frustum;
+	frustum.fromMatrices(projection, modelview);
+	viewportKey viewport;
+	glGetIntegerv(GL_VIEWPORT, viewport.v);
+	//while playing, only the hits the clock has reached, the front of each cell
+	double until = playbackHitTime(*this, innerCells, outerCells);
+	cullStats innerCulled, outerCulled;
+	drawHitSet(context.disks, hitRenderer::INNER_HITS, innerTransforms, innerCells, currentColors.inner, frustum, until, innerCulled);
+	drawHitSet(context.disks, hitRenderer::OUTER_HITS, outerTransforms, outerCells, currentColors.outer, frustum, until, outerCulled);
+	cullStats& culled = viewCulling[viewport];
+	culled.cells = innerCulled.cells + outerCulled.cells;
+	culled.cellsDrawn = innerCulled.cellsDrawn + outerCulled.cellsDrawn;
+	culled.hits = innerCulled.hits + outerCulled.hits;
+	culled.hitsDrawn = innerCulled.hitsDrawn + outerCulled.hitsDrawn;
+	//a ring round the hit the wand's on
+	const hitTransforms& picked = pickedSet == hitRenderer::OUTER_HITS ? outerTransforms : innerTransforms;
+	if(pickedSet >= 0 && pickedHit < picked.size()){
+		glPushMatrix();
+			glMultMatrixf(picked.matrix(pickedHit));
+			glColor3f(1,1,1);
+			gluDisk(quadObj, picked.radius[pickedHit] * 1.1, picked.radius[pickedHit] * 1.4, 20, 1);
+		glPopMatrix();
+	}
+	//the labels updateLabels picked out this frame
+	if(doHitLabels){
+		context.labels[hitRenderer::INNER_HITS].draw(innerLabels);
+		context.labels[hitRenderer::OUTER_HITS].draw(outerLabels);
+	}
+	HK_LOG_EVERY(LOG_TRACE, 1.0, "ended drawing dots");
+}
+
+//picks out the hits whose labels show, those near the head and the wand, once a frame for every eye and window.
+//While playing, only the hits the clock has reached, as drawn.
+void updateLabels(arMasterSlaveFramework& fw){
+	//the grids are built along with the transforms, the first time an event's drawn
+	if(!doHitLabels || !currentDots || !hitTransformsReady){
+		return;
+	}
+	//brought in to the navigated frame the hits are drawn in
+	arMatrix4 toHits = ar_getNavInvMatrix();
+	arVector3 head = toHits * ar_extractTranslation(fw.getMatrix(0));
+	arVector3 wand = toHits * ar_extractTranslation(theEffector.getCenterMatrix());
+	float viewers[6] = {head[0], head[1], head[2], wand[0], wand[1], wand[2]};
+	double until = playbackHitTime(*currentDots, innerCells, outerCells);
+	innerLabels.update(innerPicker, viewers, 2, labelRange, until);
+	outerLabels.update(outerPicker, viewers, 2, labelRange, until);
+}
+
+//the hit the wand's on: the nearest to its tip within pickRange, or else the first it points at.  Hits playback
+//hasn't reached can't be picked.
+void pickHit(){
+	pickedSet = -1;
+	//the grids are built along with the transforms, the first time an event's drawn
+	if(!currentDots || !hitTransformsReady){
+		return;
+	}
+	arMatrix4 toHits = ar_getNavInvMatrix();
+	arVector3 tip = toHits * ar_extractTranslation(theEffector.getMatrix());
+	arVector3 pointing = tip - toHits * ar_extractTranslation(theEffector.getCenterMatrix());
+	double until = playbackHitTime(*currentDots, innerCells, outerCells);
+	const hitPicker* pickers[2] = {&innerPicker, &outerPicker};
+	float best = pickRange;
+	size_t hit;
+	float distance;
+	for(int set = 0; set < 2; set++){
+		if(pickers[set]->nearest(tip.v, best, until, hit, distance)){
+			best = distance;
+			pickedSet = set;
+			pickedHit = hit;
+		}
+	}
+	if(pickedSet >= 0){
+		return;
 	}
-	for(std::vector<dot>::size_type i = 0; i != currentDots.outerDots.size();i++){
-		currentDots.outerDots[i].draw(true);
+	best = pickReach;
+	for(int set = 0; set < 2; set++){
+		if(pickers[set]->alongRay(tip.v, pointing.v, best, until, hit, distance)){
+			best = distance;
+			pickedSet = set;
+			pickedHit = hit;
+		}
 	}
-	debugText("Ended draw dots");
 }
 
 //helper function, returns true if i == menu index
@@ -757,7 +592,8 @@ bool updateMenuIndexState(int i){
 }
 
 void RodEffector::draw(arMasterSlaveFramework& framework) const {
-	debugText("began drawing rod effector");
+	HK_TIME_PHASE(PHASE_DRAW_EFFECTOR);
+	HK_LOG_EVERY(LOG_TRACE, 1.0, "began drawing rod effector");
 	glPushMatrix();
 	glMultMatrixf( getCenterMatrix().v );  //transforms to hand position
 	
@@ -813,6 +649,23 @@ void RodEffector::draw(arMasterSlaveFramework& framework) const {
 	for (char * p = text; *p; p++)
 		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
 	glPopMatrix();
+#ifdef HK_PROFILE
+	//frame times off the right of the tablet: phase, then p50 / p95 / p99 in ms
+	if(showFrameTimes){
+		glPushMatrix();
+		glTranslatef(1050,950,0);
+		glScalef(.5,.5,.5);
+		for(size_t start = 0, end; (end = frameTimesText.find('\n', start)) != string::npos; start = end + 1){
+			glPushMatrix();
+			for(size_t c = start; c < end; c++){
+				glutStrokeCharacter(GLUT_STROKE_ROMAN, frameTimesText[c]);
+			}
+			glPopMatrix();
+			glTranslatef(0,-150,0);
+		}
+		glPopMatrix();
+	}
+#endif
 	glPushMatrix();
 	glTranslatef(0,925,0);
 	text = "__________";
@@ -873,6 +726,24 @@ void RodEffector::draw(arMasterSlaveFramework& framework) const {
 	for (char * p = text; *p; p++)
 		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
 	glPopMatrix();
+	//the hit the wand's on, under the title
+	hitColumnsView pickedHits;
+	if(currentDots){
+		pickedHits = pickedSet == hitRenderer::OUTER_HITS ? currentDots->outerHits() : currentDots->innerHits();
+	}
+	if(pickedSet >= 0 && pickedHit < pickedHits.count){
+		char hitText[2][64];
+		sprintf(hitText[0], "%s PMT %u", pickedSet == hitRenderer::OUTER_HITS ? "OD" : "ID", (unsigned)pickedHits.number[pickedHit]);
+		sprintf(hitText[1], "Q %.2f  T %.1f", pickedHits.charge[pickedHit], pickedHits.time[pickedHit]);
+		for(int line = 0; line < 2; line++){
+			glPushMatrix();
+			glTranslatef(-50,840 - 70 * line,0);
+			glScalef(.6,.6,.6);
+			for (char * p = hitText[line]; *p; p++)
+				glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
+			glPopMatrix();
+		}
+	}
 	/*
 	glPushMatrix();
 	glTranslatef(0,300,0);
@@ -921,11 +792,22 @@ void RodEffector::draw(arMasterSlaveFramework& framework) const {
 	for (char * p = text; *p; p++)
 		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
 
-	itoa(dotVectors.size(),buffer,10);
+	itoa(numEvents(),buffer,10);
 	text = buffer;
 	for (char * p = text; *p; p++)
 		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
 
+	//playback on the same line, there being no room for another between this and the cone line
+	char playText[64];
+	if(autoPlay != 0){
+		sprintf(playText, "  Play: %s %.3fs", autoPlay > 0 ? "FWD" : "BACK", currentTime);
+	}
+	else{
+		sprintf(playText, "  Play: OFF");
+	}
+	for (char * p = playText; *p; p++)
+		glutStrokeCharacter(GLUT_STROKE_ROMAN, *p);
+
 	glPopMatrix();
 	glLineWidth(1.0);
 	glPopMatrix();
@@ -943,7 +825,7 @@ void RodEffector::draw(arMasterSlaveFramework& framework) const {
 			glPopMatrix();
 		}	
 	}
-	debugText("Ended drawing wand");
+	HK_LOG_EVERY(LOG_TRACE, 1.0, "ended drawing wand");
 
 }
 
@@ -1016,7 +898,7 @@ void doInterface(arMasterSlaveFramework& framework){
 	bool state = false;  //this is used to determine where the green box goes
 	char * content[10];  //no more than 10 items per line.  Gets illegible if we try to get too much smaller
 	int indexVal;
-	if(doOptionsMenu){  //hardcoded menus.
+	if(doOptionsMenu && optionsMenuPage == 0){  //hardcoded menus.
 		state = updateMenuIndexState(-2);  //each of these updateMenuIndexState lines is checking if this is currently the selected item.  If it is, this becomes true, and passes in to the drawDisplay function which adds a green box to it.  Honestly there's no reason I couldn't have just done this from within drawDisplay entirely, but it isn't computationally expensive anyhow.  TODO, make that smarter.
 		content[0] = "Main";
 		content[1] = "Menu";
@@ -1040,10 +922,33 @@ void doInterface(arMasterSlaveFramework& framework){
 		drawDisplay(1,state, content ,2,-300,100, 2);
 
 		state = updateMenuIndexState(2);
+		content[0] = "More";
+		drawDisplay(2,state, content ,1,0,0, 2);
+	}
+	if(doOptionsMenu && optionsMenuPage == 1){
+		state = updateMenuIndexState(-2);
+		content[0] = "Back";
+		drawDisplay(-2,state,content,1,0,-50,2);
+
+		state = updateMenuIndexState(-1);
 		content[0] = "Scale";
 		content[1] = "Radius";
 		content[2] = "By Q";
-		drawDisplay(2,state, content ,3,-75,200, 1.8);
+		drawDisplay(-1,state, content ,3,-75,200, 1.8);
+
+		state = updateMenuIndexState(0);
+		content[0] = "Toggle";
+		content[1] = " Hit";
+		content[2] = "Labels";
+		drawDisplay(0,state, content ,3,-35,150, 1.5);
+
+		state = updateMenuIndexState(1);
+		content[0] = "Play";
+		content[1] = (char*)(autoPlay > 0 ? " Back" : (autoPlay < 0 ? " Stop" : " Fwd"));  //what pressing it does
+		drawDisplay(1,state, content ,2,0,50, 2);
+
+		state = updateMenuIndexState(2);
+		drawDisplay(2,state, content ,0,0,0, 1);
 	}
 	if(doCherenkovConeMenu){
 		state = updateMenuIndexState(-2);
@@ -1059,18 +964,18 @@ void doInterface(arMasterSlaveFramework& framework){
 
 		int numHold = 3;  //this is 3.  If we don't have anything to write on a display, set it to 0.  We know all the other ones after that will also be 0
 		//special case, if there are 4 (or less) particles, we don't need a "more" button
-		if(currentDots.particleType.size() <= 4){
+		if(currentDots->particleType.size() <= 4){
 			for(int l = -1; l<=2;l++){
 				state = updateMenuIndexState(l);
 				indexVal = cherenkovConeMenuIndex*3+(l+1);
-				if(indexVal >= currentDots.particleType.size()){
+				if(indexVal >= currentDots->particleType.size()){
 					numHold = 0;
 				}
-				content[0] = (char*)currentDots.particleName[indexVal].c_str();
+				content[0] = (char*)currentDots->particleName[indexVal].c_str();
 				char dest[50];
-				sprintf(dest, "%i MeV", (int)currentDots.energy[indexVal]);
+				sprintf(dest, "%i MeV", (int)currentDots->energy[indexVal]);
 				content[1] = dest;
-				if(currentDots.doDisplay[indexVal]){
+				if(currentDots->doDisplay[indexVal]){
 					content[2] = "On";
 				}else{
 					content[2] = "Off";
@@ -1082,14 +987,14 @@ void doInterface(arMasterSlaveFramework& framework){
 			for(int l = -1; l<=1;l++){
 				state = updateMenuIndexState(l);
 				indexVal = cherenkovConeMenuIndex*3+(l+1);
-				if(indexVal >= currentDots.particleType.size()){
+				if(indexVal >= currentDots->particleType.size()){
 					numHold = 0;
 				}
-				content[0] = (char*)currentDots.particleName[indexVal].c_str();
+				content[0] = (char*)currentDots->particleName[indexVal].c_str();
 				char dest[50];
-				sprintf(dest, "~%i MeV", (int)currentDots.energy[indexVal]);
+				sprintf(dest, "~%i MeV", (int)currentDots->energy[indexVal]);
 				content[1] = dest;
-				if(currentDots.doDisplay[indexVal]){
+				if(currentDots->doDisplay[indexVal]){
 					content[2] = "On";
 				}else{
 					content[2] = "Off";
@@ -1143,284 +1048,188 @@ void doInterface(arMasterSlaveFramework& framework){
 	glLineWidth(1.0);
 }
 
-/*  logic to fill a dotVector.  Reads from the file and populates a dotVector until it hits a NEXTEVENT line, where it will do the physics calculation for each final particle to determine cone angle, and then stores the dot vector and exits */
-void loadNextEvent(void) {
-	int hit;
-	arVector3 theta;
-	double x,y,z,q,t,xd,yd,zd;
-	string type;
-	double filler;
-	double time;
-	double vx, vy,vz;
-	vector<double> particleType, dx, dy, dz, momentum, id;
-
-	//double particleType, dx, dy, dz, momentum, id;
-	double particleType2, dx2, dy2, dz2, momentum2, id2;
-	//momentum = 0;
-	double momentumHold = 0;
-	vector<dot> dots;
-	vector<dot> outerDots;
-	bool debug = false;
-	if(dataFile.is_open()) {
-		while (dataFile.good()) {
-			dataFile >> type;
-			if(type == "ID"){  //parse inner detector
-				dataFile >> filler >> hit >> x >> y >> z >> xd >> yd >> zd >> q >> t;
-				tempDot = dot(hit, x,y,z, xd, yd, zd,q,t,innerDotRad);
-				dots.push_back(tempDot);
-				//if(y > 0 && yd == -1)
-					//cout << hit << " " << x << " " << y << " " << z << "\n";
-			}
-			if(type == "OD"){  //parse outer detector
-				dataFile >> filler >> hit >> x >> y >> z >> xd >> yd >> zd >> q >> t;
-				x = x / 100.0;
-				y = y / 100.0;
-				z = z * 20.0 / 1810.0 + 20.0;
-				tempDot = dot(hit, x,y,z,xd, yd, zd,q,t,outerDotRad);
-				outerDots.push_back(tempDot);
-			}
-			if(type == "TIME"){ //parse time info
-				dataFile >> time;
-			}
-			if(type == "VERTEX"){  //vertex location of particle
-				dataFile >> vx >> vy >> vz;
-				vx = vx / 100 * 3.28;
-				vy = vy / 100 * 3.28;
-				vz = vz * 20.0 / 1810.0 + 20.0;
-				vz = vz * 3.28;
-			}
-			if(type == "PARTICLE"){  //particle information -- momentum and direction of cone
-				dataFile >> particleType2 >> dx2 >> dy2 >> dz2 >> momentum2 >> id2;
-
-				particleType.push_back(particleType2);
-				dx.push_back(dx2);
-				dy.push_back(dy2);
-				dz.push_back(dz2);
-				momentum.push_back(momentum2);
-				id.push_back(id2);
-			}
-			if(type == "NEXTEVENT"){  //store everything, create a new event
-				currentDots.dots = dots;
-				currentDots.outerDots = outerDots;
-				currentDots.endTime = time;
-				currentDots.vertexPosition[0] = vx;
-				currentDots.vertexPosition[1] = vy;
-				currentDots.vertexPosition[2] = vz;
-
-				//store type
-				for(int i = 0; i < particleType.size();i++){
-					currentDots.particleType.push_back(particleType[i]);
-
-					//normalize conedirection and store
-					double mag = pow(dx[i],2) + pow(dy[i],2) + pow(dz[i],2);
-					mag = sqrt(mag);
-					arVector3 coneDirHold = arVector3(dx[i]/mag,dy[i]/mag,dz[i]/mag);
-					currentDots.coneDirection.push_back(coneDirHold);
-
-					//calculate angle
-#ifdef WINNEUTRINO
-					double momentumConverted = momentum[i] * pow(10.0,6) * 1.6e-19 / 2.998e8;
-#else
-					double momentumConverted = momentum[i] * pow(10,6) * 1.6e-19 / 2.998e8;
-#endif
-					double mass = electronMass;  //assume electron to start .. ID of electron is 11 / -11
-					double cherenkovThreshold = cherenkovElectronThreshold;
-					if(abs(currentDots.particleType[i]) == 13){  //id 13 and -13 is muon
-						mass = muonMass;
-						cherenkovThreshold = cherenkovMuonThreshold;
-					}
-					if(abs(currentDots.particleType[i]) == 211){  //id 211 and -211 is pion
-						mass = pionMass;
-						cherenkovThreshold = cherenkovPionThreshold;
-					}
-					double velocity = sqrt(pow(momentumConverted,2) / (pow(mass,2)+pow(momentumConverted,2)/pow(speedOfLight,2)));  //calculating velocity from momentum and mass, have to take in to account lorentz factor
-					double energy = sqrt(pow(momentumConverted,2)*pow(speedOfLight,2)+pow(mass,2)*pow(speedOfLight,4)) / 1.602e-13;  //calculate total energy from velocity, convert to MeV
-
-					if(energy > cherenkovThreshold){ //checks if it's over cherenkov energy threshold  ... I don't think this is actually doing anything meaningful right now
-						double beta = velocity / speedOfLight;  //in m/s  
-						double n = 1.33; 
-						double angle = acos(1.0 / (beta * n)) * 180. / PI;  //angle in degrees, using equation cos(theta) = 1 / (n*beta) for cherenkov energy
-						currentDots.coneAngle.push_back(angle);
-					}
-					else{
-						currentDots.coneAngle.push_back(0);
-					}
-					currentDots.momentum.push_back(momentum[i]);
-					currentDots.energy.push_back(energy);
-					//and start an empty ringPoints class to be filled later
-					vector<ringPointHolder> me;
-					ringPointHolder me2;
-					me.push_back(me2);
-					me.push_back(me2);
-					currentDots.ringPoints.push_back(me);
-					currentDots.haveRingPoints.push_back(false); //since we haven't generated any ring points, fill this with false
-					currentDots.doDisplay.push_back(false); //turn off all displays, in the next step we'll go ahead and turn on only the highest momentum particle
-					//set haveRingPoints to false, this will have them be generated on the first frame
-
-					string text = "???";
-					if(currentDots.particleType[i] == 11){
-						text = "Electron";
-					}
-					else if(currentDots.particleType[i] == -11){
-						text = "Positron";
-					}
-					else if(currentDots.particleType[i] == 13){
-						text = "Muon";
-					}
-					else if(currentDots.particleType[i] == -13){
-						text = "Antimuon";
-					}
-					else if(currentDots.particleType[i] == 211){
-						text = "Pion+";
-					}
-					else if(currentDots.particleType[i] == -211){
-						text = "Pion-";
-					}
-					else{
-						char me[100];
-						printf(me,"%i",(int)currentDots.particleType[i]);
-						text = me;
-					}
-					currentDots.particleName.push_back(text);
-
-				}
-
-				//we'll go ahead and load in the START TIME which is the END TIME of the previous event
-				if(dotVectors.size() == 0){ //if we're the first event, start time is 0, length is thus 'time'
-					currentDots.startTime = 0.0;
-					currentDots.length = time;
-				}else{
-					int tempIndex = dotVectors.size()-1;  //this is the most recently added event (before the currently generated one)
-					currentDots.startTime = dotVectors[tempIndex].endTime; 
-					currentDots.length = time - currentDots.startTime;
-				}
-				return;
-			}
-			if(dataFile.fail()) break;
-
+//opens the file for streaming, binary or text
+eventSource* openEventSource(const char* path){
+	if(isEventBinaryFile(path)){
+		binaryEventSource* source = new binaryEventSource;
+		string error;
+		if(!source->open(path, error)){
+			cout << error << "\n";
+			exit(0);
 		}
-		if(dataFile.fail() || !dataFile.good()) dataFile.close();
-	} else {
-		printf("file was not open! \n");
-		throw 9001; //really?
+		return source;
 	}
-}
-
-//reads in file, looping over loadNextEvent until an error is thrown (eg, the file has no more data)
-void readInFile(arMasterSlaveFramework& fw){
-	debugText("started read in file");
-	char me[100];
-	strcpy(me, filename);
-	//strcpy(me,"data/");
-	//strcat(me,filename);
-	//dataFile.open("C:/users/owner/desktop/glut_cylinder/temp");
-	dataFile.open(me);  //relative pathing, may be really temperamental ... run from SRC
-	if(!dataFile.is_open()) {
+	textEventSource* source = new textEventSource;
+	if(!source->open(path)){
 		cout << "Unable to open file";
 		exit(0);
 	}
+	return source;
+}
+
+//reads in file, looping over eventParser::loadNextEvent until the file has no more data.  Binary (.hkev) files are mapped instead of parsed.
+void readInFile(arMasterSlaveFramework& fw){
+	HK_LOG(LOG_INFO, "reading %s", filename);
 	index = 0;
-	while(true){
-		try{
-			loadNextEvent();
-			dotVectors.push_back(currentDots);
-			currentDots = dotVector();
+	if(streamBudget > 0){
+		//streaming: only the events around 'index' are decoded, everything else is left in the file
+		eventSource* source = openEventSource(filename);
+		if(doTimeCompressed){
+			source = new compressedEventSource(source, timeStep);
 		}
-		catch (int e){
-			break;
+		if(source->size() == 0){
+			cout << "No events in file";
+			exit(0);
 		}
+		streamedEvents = new eventCache(source, streamBudget, streamWindow);
+		streamedEvents->setCurrent(index);
+		currentDots = &streamedEvents->get(index);
+		currentIndex = index;
+		HK_LOG(LOG_INFO, "read %lu events", (unsigned long)numEvents());
+		return;
 	}
 
-	//file is read by now.  Now we're going to go ahead and compress events if we're doing time compression
+	if(isEventBinaryFile(filename)){
+		string error;
+		if(!eventFile.open(filename, error)){
+			cout << error << "\n";
+			exit(0);
+		}
+		dotVectors.reserve(dotVectors.size() + eventFile.numEvents());
+		for(size_t i = 0; i < eventFile.numEvents(); i++){
+			dotVectors.push_back(dotVector());
+			eventFile.makeEvent(i, dotVectors.back());
+		}
+	}
+	else{
+		mappedFile text;
+		string error;
+		if(!text.open(filename, error)) {  //relative pathing, may be really temperamental ... run from SRC
+			cout << "Unable to open file";
+			exit(0);
+		}
+		double startTime = dotVectors.empty() ? 0.0 : dotVectors.back().endTime;
+		parseStats stats = parseEvents(text.data(), text.data() + text.size(), dotVectors, startTime, parseThreads);
+		HK_LOG(LOG_INFO, "%s", stats.report().c_str());
+	}
 
-	double timeStep = .05;
-	index = 0;
+	//file is read by now.  Now we're going to go ahead and compress events if we're doing time compression
 	if(doTimeCompressed){  //here we have to compress all events in to a smaller number of events
-		vector<dotVector> newDotVectors;
-		newDotVectors.push_back(dotVectors[0]);
-		currentDots = dotVector();
-		currentDots.startTime = 0;
-		for(int i = 1; i < dotVectors.size(); i++){
-			if(dotVectors[i].startTime >= timeStep * index){
-				currentDots.endTime = timeStep*index;
-				currentDots.length = currentDots.endTime - currentDots.startTime;
-				newDotVectors.push_back(currentDots);
-				currentDots = dotVector();
-				currentDots.startTime = timeStep*index;
-				index++;
-				continue;
-			}
-			for(int k = 0; k < dotVectors[i].dots.size(); k++){
-				bool found = false;
-				//search all existing dots in this event, see if any have the same vertex position, if so, just add this one's charge to that one
-				for(int l = 0; l < currentDots.dots.size(); l++){
-					if(dotVectors[i].dots[k].cx == currentDots.dots[l].cx && dotVectors[i].dots[k].cy == currentDots.dots[l].cy && dotVectors[i].dots[k].cz == currentDots.dots[l].cz){
-						found = true;
-						currentDots.dots[l].charge += dotVectors[i].dots[k].charge;
-						break;
-					}
-				}
-				if(!found){
-					currentDots.dots.push_back(dotVectors[i].dots[k]);
-				}
-			}
-			for(int k = 0; k < dotVectors[i].outerDots.size();k++){
-				bool found = false;
-				//same deal with outer dots.
-				for(int l = 0; l < currentDots.outerDots.size(); l++){
-					if(dotVectors[i].outerDots[k].cx == currentDots.outerDots[l].cx && dotVectors[i].outerDots[k].cy == currentDots.outerDots[l].cy && dotVectors[i].outerDots[k].cz == currentDots.outerDots[l].cz){
-						found = true;
-						currentDots.outerDots[l].charge += dotVectors[i].outerDots[k].charge;
-						break;
-					}
-				}
-				if(!found){
-					currentDots.outerDots.push_back(dotVectors[i].outerDots[k]);
-				}
-			}
-			currentDots.energy.push_back(dotVectors[i].vertexPosition[0]);
-			currentDots.energy.push_back(dotVectors[i].vertexPosition[1]);
-			currentDots.energy.push_back(dotVectors[i].vertexPosition[2]);
-		}
-		currentDots.endTime = dotVectors[dotVectors.size()-1].endTime;
-		currentDots.length = currentDots.endTime - currentDots.startTime;
-		newDotVectors.push_back(currentDots);
-		dotVectors = newDotVectors;
+		compressEvents(dotVectors, timeStep, parseThreads);
 	}
 
-	index = 0;
+	//now, we turn on display for first listed final state particle of each event
+	for(size_t e = 0; e < dotVectors.size(); e++){
+		setDefaultDisplay(dotVectors[e]);
+	}
 
+	currentDots = &dotVectors[index];
+	currentIndex = index;
+	HK_LOG(LOG_INFO, "read %lu events", (unsigned long)numEvents());
+}
 
-	//now, we turn on display for first listed final state particle of each event
-	//we do it here and not in Loadevent because I was getting a weird bug trying to do it there and got lazy
-	for(int e = 0; e < dotVectors.size(); e++){
-		int holder = 0;
-		/*
-		for(int i = 0; i < dotVectors[e].doDisplay.size(); i++){
-		if(dotVectors[e].energy[i] > dotVectors[e].energy[holder]){
-		holder = i;
-		}
-		}
-		*/    if(dotVectors[e].doDisplay.size() > 0){
-			dotVectors[e].doDisplay[0] = true;
-		}
 
-		//also go ahead and draw the scene to pre-load cones
-		currentDots = dotVectors[e];
-		//drawScene(fw);
+// Master-slave transfer variables
+// Everything the slaves show that isn't the navigation matrix or the events themselves (the square, the event
+// index, the menus and options) goes in one sharedState, see sharedState.h.  The effector's matrix can be updated
+// by calling updateState(), see below.
+stateSender stateOut(60);     //the master's: sends the state when it changes, and every 60 frames
+displayChannel displayLog;    //the master's display toggles, copied in to every state it sends
+hkUint32 displayApplied = 0;  //a slave's, the last of those it's applied
+bool displayJoined = false;   //a slave's, whether it's had a state from the master yet
+vector<displayChange> displayChanges;  //scratch
+
+//the master's state as of now
+void packState(sharedState& state){
+	memset(&state, 0, sizeof(state));
+	state.index = index;
+	state.autoPlay = autoPlay;
+	state.currentTime = currentTime;
+	state.pickedSet = pickedSet;
+	state.pickedHit = (hkUint32)pickedHit;
+	state.menuIndex = menuIndex;
+	state.optionsMenuPage = optionsMenuPage;
+	state.cherenkovConeMenuIndex = cherenkovConeMenuIndex;
+	state.itemTouching = itemTouching;
+	state.flags = (doMenu ? STATE_MENU : 0) | (doMainMenu ? STATE_MAIN_MENU : 0) | (doOptionsMenu ? STATE_OPTIONS_MENU : 0)
+		| (doCherenkovConeMenu ? STATE_CHERENKOV_MENU : 0) | (doColorKey ? STATE_COLOR_KEY : 0)
+		| (colorByCharge ? STATE_COLOR_BY_CHARGE : 0) | (doCylinderDivider ? STATE_CYLINDER_DIVIDER : 0)
+		| (doScaleByCharge ? STATE_SCALE_BY_CHARGE : 0) | (doHitLabels ? STATE_HIT_LABELS : 0)
+		| (isTouchingVertex ? STATE_TOUCHING_VERTEX : 0) | (isGrabbingVertex ? STATE_GRABBING_VERTEX : 0)
+		| (triggerDepressed ? STATE_TRIGGER : 0) | (theSquare.getHighlight() ? STATE_SQUARE_HIGHLIGHTED : 0)
+		| (doCherenkovCone ? STATE_CHERENKOV_CONE : 0);
+	arMatrix4 square = theSquare.getMatrix();
+	memcpy(state.squareMatrix, square.v, sizeof(state.squareMatrix));
+	state.display = displayLog;
+	if(currentDots){
+		packShownDisplay(state.shown, currentIndex, currentDots->doDisplay);
 	}
+}
 
-	currentDots = dotVectors[index];
-	debugText("ended read in file");
+//a slave takes on the master's state
+void unpackState(const sharedState& state){
+	index = state.index;
+	autoPlay = state.autoPlay;
+	currentTime = state.currentTime;
+	pickedSet = state.pickedSet;
+	pickedHit = state.pickedHit;
+	menuIndex = state.menuIndex;
+	optionsMenuPage = state.optionsMenuPage;
+	cherenkovConeMenuIndex = state.cherenkovConeMenuIndex;
+	itemTouching = state.itemTouching;
+	doMenu = (state.flags & STATE_MENU) != 0;
+	doMainMenu = (state.flags & STATE_MAIN_MENU) != 0;
+	doOptionsMenu = (state.flags & STATE_OPTIONS_MENU) != 0;
+	doCherenkovConeMenu = (state.flags & STATE_CHERENKOV_MENU) != 0;
+	doColorKey = (state.flags & STATE_COLOR_KEY) != 0;
+	colorByCharge = (state.flags & STATE_COLOR_BY_CHARGE) != 0;
+	doCylinderDivider = (state.flags & STATE_CYLINDER_DIVIDER) != 0;
+	doScaleByCharge = (state.flags & STATE_SCALE_BY_CHARGE) != 0;
+	doHitLabels = (state.flags & STATE_HIT_LABELS) != 0;
+	isTouchingVertex = (state.flags & STATE_TOUCHING_VERTEX) != 0;
+	isGrabbingVertex = (state.flags & STATE_GRABBING_VERTEX) != 0;
+	triggerDepressed = (state.flags & STATE_TRIGGER) != 0;
+	theSquare.setHighlight((state.flags & STATE_SQUARE_HIGHLIGHTED) != 0);
+	doCherenkovCone = (state.flags & STATE_CHERENKOV_CONE) != 0;
+	theSquare.setMatrix(state.squareMatrix);
+	//joining late, the changes logged before the ring's oldest are gone; the shown event's toggles below stand in
+	if(!newDisplayChanges(state.display, displayApplied, displayChanges) && displayJoined){
+		HK_LOG(LOG_WARN, "missed some cone display changes from the master");
+	}
+	displayJoined = true;
+	for(size_t c = 0; c < displayChanges.size(); c++){
+		const displayChange& change = displayChanges[c];
+		if(change.event < numEvents()){
+			setEventDisplay(change.event, change.particle, change.on != 0);
+		}
+	}
+	//the master's toggles for the event it shows, in full, once this slave shows it too
+	const shownDisplay& shown = state.shown;
+	if(currentDots && currentIndex == shown.event){
+		for(size_t p = 0; p < shown.particles && p < currentDots->doDisplay.size(); p++){
+			bool on = shownDisplayOn(shown, p);
+			if(currentDots->doDisplay[p] != on){
+				setEventDisplay(currentIndex, p, on);
+			}
+		}
+	}
 }
 
+//the master turns a cone on or off, for itself and the slaves
+void changeEventDisplay(size_t event, size_t particle, bool on){
+	setEventDisplay(event, particle, on);
+	recordDisplayChange(displayLog, event, particle, on);
+}
 
-// Master-slave transfer variables
-// All we need to explicity transfer in this program is the square's placement matrix and
-// whether or not the it is highlighted (the effector's matrix can be updated by calling 
-// updateState(), see below).
-int squareHighlightedTransfer = 0;
-arMatrix4 squareMatrixTransfer;
+//resizes an internal transfer field to 'bytes' and fills it
+void setTransferBytes(arMasterSlaveFramework& fw, const char* name, const void* data, size_t bytes){
+	fw.setInternalTransferFieldSize(name, AR_CHAR, (int)bytes);
+	int size = 0;
+	char* field = (char*)fw.getTransferField(name, AR_CHAR, size);
+	if(field && size == (int)bytes){
+		memcpy(field, data, bytes);
+	}
+}
 
 // start callback (called in arMasterSlaveFramework::start()
 //
@@ -1430,26 +1239,8 @@ arMatrix4 squareMatrixTransfer;
 bool start( arMasterSlaveFramework& framework, arSZGClient& /*cli*/ ) {
   // Register shared memory.
   //  framework.addTransferField( char* name, void* address, arDataType type, int numElements ); e.g.
-	framework.addTransferField("squareHighlighted", &squareHighlightedTransfer, AR_INT, 1);
-	framework.addTransferField("squareMatrix", squareMatrixTransfer.v, AR_FLOAT, 16);
-	framework.addTransferField("indexTransferField",&index,AR_INT,1);
-	framework.addTransferField("autoPlayTransfer",&autoPlay,AR_INT,1);
-	framework.addTransferField("colorByChargeTransfer",&colorByCharge,AR_INT,1);
-	framework.addTransferField("doCylinderDividerTransfer",&doCylinderDivider,AR_INT,1);
-	framework.addTransferField("doScaleByChargeTransfer",&doScaleByCharge,AR_INT,1);
-	framework.addTransferField("doMenuTransfer",&doMenu,AR_INT,1);
-	framework.addTransferField("menuIndexTransfer",&menuIndex,AR_INT,1);
-	framework.addTransferField("optionsTransfer",&doOptionsMenu,AR_INT,1);
-	framework.addTransferField("menuIndexX",&menuIndex,AR_INT,1);
-	framework.addTransferField("colorKeyX",&doColorKey,AR_INT,1);
-	framework.addTransferField("doCherenkovMenuTransfer",&doCherenkovConeMenu,AR_INT,1);
-	framework.addTransferField("doMainMenuTransfer",&doMainMenu,AR_INT,1);
-	framework.addTransferField("CherenkovConeMenuIndexIndexTransfer",&cherenkovConeMenuIndex,AR_INT,1);
-	framework.addTransferField("modifiedCherenkovConeItem",&modifiedCherenkovConeIndex,AR_INT,1);	
-	framework.addTransferField("isTouchingVertex",&isTouchingVertex,AR_INT,1);
-	framework.addTransferField("isGrabbingVertex",&isGrabbingVertex,AR_INT,1);
-	framework.addTransferField("itemTouching",&itemTouching ,AR_INT,1);
-	framework.addTransferField("starttransfer", &triggerDepressed, AR_INT, 1);
+  // Ours all goes in one packed block, sized each frame by preExchange.
+	framework.addInternalTransferField("state", AR_CHAR, 1);
 
   // Setup navigation, so we can drive around with the joystick
   //
@@ -1468,7 +1259,23 @@ bool start( arMasterSlaveFramework& framework, arSZGClient& /*cli*/ ) {
   
   // set square's initial position
   theSquare.setMatrix( ar_translationMatrix(0,5,-6) );
- 
+
+  //the data every window draws from, loaded once per process however many windows there are.  With -distribute,
+  //slaves don't touch the file and are sent the events around the current one instead.
+  if(distributeBytes > 0){
+    framework.addInternalTransferField("eventPayload", AR_CHAR, 1);
+  }
+  if(distributeBytes > 0 && !framework.getMaster()){
+    receivedEvents = new eventReceiver(streamWindow);
+  }
+  else{
+    readInFile(framework);  //opens the file
+    if(distributeBytes > 0){
+      sentEvents = new eventSender(streamWindow, distributeBytes, 600);  //sends the window again every 600 frames, for slaves that start late
+    }
+  }
+  myDetector.initialize();
+  coneRings = new ringWorkers(2, 64);
 
   return true;
 }
@@ -1481,17 +1288,23 @@ void windowStartGL( arMasterSlaveFramework& fw, arGUIWindowInfo* ) {
   glClearColor(0,0,0,0);
   
   //for drawing quadrics
-  quadObj = gluNewQuadric(); 
-  
-  readInFile(fw);  //opens the file
-  
-  myDetector.initialize();
+  if(!quadObj){
+    quadObj = gluNewQuadric();
+  }
+
+  //this window's buffers and shaders, drawing from what start() loaded
+  currentGL();
+  string labelError;
+  if(!hitLabels::init(labelError)){
+    HK_LOG(LOG_WARN, "%s", labelError.c_str());
+  }
 }
 
 // Callback called before data is transferred from master to slaves. Only called
 // on the master. This is where anything having to do with
 // processing user input or random variables should happen.
 void preExchange( arMasterSlaveFramework& fw ) {
+  HK_TIME_PHASE(PHASE_PRE_EXCHANGE);
   // Do stuff on master before data is transmitted to slaves.
 
   // handle joystick-based navigation (drive around). The resulting
@@ -1505,11 +1318,6 @@ void preExchange( arMasterSlaveFramework& fw ) {
   // Any grabbing/dragging happens in here.
   ar_pollingInteraction( theEffector, (arInteractable*)&theSquare );
 
-  // Pack data destined for slaves into appropriate variables
-  // (bools transfer as ints).
-  squareHighlightedTransfer = (int)theSquare.getHighlight();
-  squareMatrixTransfer = theSquare.getMatrix();
-
 	//do button presses
 		if(fw.getOnButton(0)){  // on yellow button, step event back one if menus aren't up, step menu index back one if menus are up...replace stepping with autoplay if we're doing time compression
 			if(doMenu){
@@ -1604,12 +1412,26 @@ void preExchange( arMasterSlaveFramework& fw ) {
 						doMainMenu = false;
 					}
 					if(menuIndex == 2){
-						if(index < dotVectors.size() - 1){
+						if(index < numEvents() - 1){
 							index++;
 						}
 						autoPlay = 0;
 					}
 				}
+				else if(doOptionsMenu && optionsMenuPage == 1){
+					if(menuIndex == -2){
+						optionsMenuPage = 0;
+					}
+					if(menuIndex == -1){
+						doScaleByCharge = !doScaleByCharge;
+					}
+					if(menuIndex == 0){
+						doHitLabels = !doHitLabels;
+					}
+					if(menuIndex == 1){  //forward, then back, then off
+						setPlayback(autoPlay > 0 ? -1 : (autoPlay < 0 ? 0 : 1));
+					}
+				}
 				else if(doOptionsMenu){
 					if(menuIndex == -2){
 						doOptionsMenu = false;
@@ -1625,7 +1447,7 @@ void preExchange( arMasterSlaveFramework& fw ) {
 						colorByCharge = !colorByCharge;
 					}
 					if(menuIndex == 2){
-						doScaleByCharge = !doScaleByCharge;
+						optionsMenuPage = 1;
 					}
 				}
 				else if(doCherenkovConeMenu){  //
@@ -1639,25 +1461,22 @@ void preExchange( arMasterSlaveFramework& fw ) {
 						}
 					}
 					if(menuIndex == -1){
-						if((cherenkovConeMenuIndex * 3 + 0) < currentDots.particleType.size()){
-							dotVectors[index].doDisplay[cherenkovConeMenuIndex*3 + 0] = !currentDots.doDisplay[cherenkovConeMenuIndex*3 + 0];
-							modifiedCherenkovConeIndex = cherenkovConeMenuIndex*3 + 0;
+						if((cherenkovConeMenuIndex * 3 + 0) < currentDots->particleType.size()){
+							changeEventDisplay(index, cherenkovConeMenuIndex*3 + 0, !currentDots->doDisplay[cherenkovConeMenuIndex*3 + 0]);
 						}
 					}
 					if(menuIndex == 0){
-						if((cherenkovConeMenuIndex * 3 + 1) < currentDots.particleType.size()){
-							dotVectors[index].doDisplay[cherenkovConeMenuIndex*3 + 1] = !currentDots.doDisplay[cherenkovConeMenuIndex*3 + 1];
-							modifiedCherenkovConeIndex = cherenkovConeMenuIndex*3 + 1;
+						if((cherenkovConeMenuIndex * 3 + 1) < currentDots->particleType.size()){
+							changeEventDisplay(index, cherenkovConeMenuIndex*3 + 1, !currentDots->doDisplay[cherenkovConeMenuIndex*3 + 1]);
 						}
 					}
 					if(menuIndex == 1){
-						if((cherenkovConeMenuIndex * 3 + 2) < currentDots.particleType.size()){
-							dotVectors[index].doDisplay[cherenkovConeMenuIndex*3 + 2] = !currentDots.doDisplay[cherenkovConeMenuIndex*3 + 2];
-							modifiedCherenkovConeIndex = cherenkovConeMenuIndex*3 + 2;
+						if((cherenkovConeMenuIndex * 3 + 2) < currentDots->particleType.size()){
+							changeEventDisplay(index, cherenkovConeMenuIndex*3 + 2, !currentDots->doDisplay[cherenkovConeMenuIndex*3 + 2]);
 						}
 					}
 					if(menuIndex == 2){
-						if(cherenkovConeMenuIndex <= (currentDots.particleType.size()-1) / 3){
+						if(cherenkovConeMenuIndex <= (currentDots->particleType.size()-1) / 3){
 							cherenkovConeMenuIndex++;
 						}
 					}
@@ -1665,11 +1484,36 @@ void preExchange( arMasterSlaveFramework& fw ) {
 
 			}
 		}
+
+	stepPlayback(fw);
+	pickHit();
+
+	//the slaves get the state only when it's changed, or just its sequence number otherwise
+	sharedState state;
+	packState(state);
+	if(stateOut.frame(state)){
+		setTransferBytes(fw, "state", &state, sizeof(state));
+	}
+	else{
+		setTransferBytes(fw, "state", &state.sequence, sizeof(state.sequence));
+	}
+
+	//send the slaves whatever they're missing around the event they're about to show
+	if(sentEvents){
+		sentEvents->frame(index, numEvents(), eventAt, eventMessage);
+		setTransferBytes(fw, "eventPayload", &eventMessage[0], eventMessage.size());
+		//fetching those may have pushed the shown event out of the stream cache
+		if(streamedEvents && currentDots && &eventAt(currentIndex) != currentDots){
+			currentDots = &eventAt(currentIndex);
+			hitTransformsReady = false;
+		}
+	}
 }
 
 // Callback called after transfer of data from master to slaves. Mostly used to
 // synchronize slaves with master based on transferred data.
 void postExchange( arMasterSlaveFramework& fw ) {
+  HK_TIME_PHASE(PHASE_POST_EXCHANGE);
   // Do stuff after slaves got data and are again in sync with the master.
   if (!fw.getMaster()) {
     
@@ -1677,20 +1521,95 @@ void postExchange( arMasterSlaveFramework& fw ) {
     // to be updated, for rendering purposes.
     theEffector.updateState( fw.getInputState() );
 
-    // Unpack our transfer variables.
-    theSquare.setHighlight( (bool)squareHighlightedTransfer );
-    theSquare.setMatrix( squareMatrixTransfer.v );
+    // Unpack our transfer variables, if the master's sent a new lot.
+    int size = 0;
+    const char* field = (const char*)fw.getTransferField("state", AR_CHAR, size);
+    if (field && size == (int)sizeof(sharedState)) {
+      sharedState state;
+      memcpy(&state, field, sizeof(state));
+      if (state.version == sharedStateVersion) {
+        unpackState(state);
+      }
+    }
+
+    if (receivedEvents) {
+      size = 0;
+      const char* message = (const char*)fw.getTransferField("eventPayload", AR_CHAR, size);
+      if (message) {
+        receivedEvents->receive(message, size, index);
+      }
+    }
   }
   
-  currentDots = dotVectors[index];
+  //only fetch the event when the index moves, drawing works straight off the stored event.  On a slave it's fetched
+  //again when the one being waited for arrives, and when the one shown is dropped (as one not sent again for a whole
+  //generation is), so currentDots falls back to the placeholder rather than being left on a freed event.
+  bool arrived = receivedEvents && currentIndex == (size_t)index && receivedEvents->has(index) && currentDots != &eventAt(index);
+  bool dropped = receivedEvents && !receivedEvents->has(currentIndex) && currentDots != &eventAt(currentIndex);
+  if(!currentDots || (size_t)index != currentIndex || arrived || dropped){
+    if(streamedEvents){
+      streamedEvents->setCurrent(index);
+    }
+    currentDots = &eventAt(index);
+    currentIndex = index;
+    hitTransformsReady = false;
+  }
+  updateRings();
+  updateLabels(fw);
+}
+
+#ifdef HK_PROFILE
+// Writes every frame time still held to frametimes.csv
+void exitCallback( arMasterSlaveFramework& ) {
+  if (!frameTimes::writeCsv("frametimes.csv")) {
+    cout << "couldn't write frametimes.csv\n";
+  }
+}
+#endif
+
+//the rings of the particles shown, with lines out to them from the vertex
+void drawRings(const dotVector& event){
+  double vertex[3];
+  vertexInHitFrame(event, vertex);
+  glColor3f(1,1,0);
+  for(size_t p = 0; p < event.ringPoints.size(); p++){
+    if(!event.doDisplay[p] || !event.haveRingPoints[p] || event.ringPoints[p].size() < 2){
+      continue;
+    }
+    const vector<vec3>& ring = event.ringPoints[p][0].ringPoints;
+    const vector<vec3>& spokes = event.ringPoints[p][1].ringPoints;
+    glBegin(GL_LINE_STRIP);
+    for(size_t k = 0; k < ring.size(); k++){
+      glVertex3fv(ring[k].v);
+    }
+    glEnd();
+    glBegin(GL_LINES);
+    for(size_t k = 0; k < spokes.size(); k++){
+      glVertex3dv(vertex);
+      glVertex3fv(spokes[k].v);
+    }
+    glEnd();
+  }
 }
 
 void display( arMasterSlaveFramework& fw ) {
+  HK_TIME_PHASE(PHASE_DISPLAY);
+#ifdef HK_PROFILE
+  if (showFrameTimes && frameTimes::now() - frameTimesShown > 500) {
+    frameTimesText = frameTimes::report(256);
+    frameTimesShown = frameTimes::now();
+  }
+#endif
   // Load the navigation matrix.
   fw.loadNavMatrix();
   
   //tell dots to draw themselves
-  currentDots.draw(fw);
+  if(currentDots){
+    currentDots->draw(fw);
+    if(doCherenkovCone){
+      drawRings(*currentDots);
+    }
+  }
   
   // Draw stuff.
   theEffector.draw(fw);
@@ -1714,6 +1633,18 @@ void keypress( arMasterSlaveFramework& fw, arGUIKeyInfo* keyInfo ) {
     stateString = "UNKNOWN";
   }
   cout << "Key state = " << stateString << endl;
+#ifdef HK_PROFILE
+  if (state == AR_KEY_DOWN && keyInfo->getKey() == 't') {
+    showFrameTimes = !showFrameTimes;
+  }
+#endif
+  //'c' prints how much of the event each viewport drew last frame
+  if (state == AR_KEY_DOWN && keyInfo->getKey() == 'c') {
+    for (map<viewportKey, cullStats>::const_iterator v = viewCulling.begin(); v != viewCulling.end(); ++v) {
+      const GLint* at = v->first.v;
+      cout << "viewport " << at[0] << " " << at[1] << " " << at[2] << " " << at[3] << ": " << v->second.report() << endl;
+    }
+  }
 }
     
 // This is how we have to catch reshape events now, still
@@ -1744,6 +1675,43 @@ int main(int argc, char** argv) {
 		cout << argv[2];
 		cout << "\n";
 	}
+	for(int i = 2; i < argc - 1; i++){
+		if(!strcmp(argv[i], "-stream")){
+			streamBudget = (size_t)(atof(argv[i+1]) * 1024 * 1024);
+		}
+		if(!strcmp(argv[i], "-window")){
+			streamWindow = atoi(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-threads")){
+			parseThreads = atoi(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-timestep")){
+			doTimeCompressed = true;
+			timeStep = atof(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-detectorslices")){
+			detectorSlices = atoi(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-distribute")){
+			distributeBytes = (size_t)(atof(argv[i+1]) * 1024);
+		}
+		if(!strcmp(argv[i], "-labels")){
+			labelRange = atof(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-playrate")){
+			timeScaleFactor = atof(argv[i+1]);
+		}
+		if(!strcmp(argv[i], "-loglevel")){
+			logger::setLevel(atoi(argv[i+1]));
+		}
+		if(!strcmp(argv[i], "-colors")){
+			string error;
+			if(!hitScales.load(argv[i+1], error)){
+				cout << error << "\n";
+				exit(0);
+			}
+		}
+	}
 	arMasterSlaveFramework framework;
 	// Tell the framework what units we're using.
 	framework.setUnitConversion(FEET_TO_LOCAL_UNITS);
@@ -1755,6 +1723,9 @@ int main(int argc, char** argv) {
 	framework.setDrawCallback(display);
 	framework.setKeyboardCallback( keypress );
 	framework.setWindowEventCallback( windowEvent );
+#ifdef HK_PROFILE
+	framework.setExitCallback( exitCallback );
+#endif
 	// also setExitCallback(), setUserMessageCallback()
 	// in demo/arMasterSlaveFramework.h
 